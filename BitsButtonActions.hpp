@@ -0,0 +1,104 @@
+#pragma once
+
+#include "BitsButtonXR.hpp"
+
+/**
+ * @brief One (button, event) to command binding
+ * @tparam Command Command ID type or handler function pointer
+ */
+template <typename Command> struct BitsButtonActionBinding {
+  const char *key_alias; ///< Single or combined button alias
+  BitsButtonEvent event; ///< Event type that triggers the command
+  Command command;       ///< Command ID or handler
+};
+
+/**
+ * @brief Dense action table of one mode/layer
+ * @tparam Command Command ID type or handler function pointer, the value
+ * initialized Command (0 / nullptr) means "no action"
+ *
+ * Aliases are resolved once at construction, so every later lookup is a
+ * single indexed load by logic index and event type.
+ * @code
+ * enum Cmd : uint16_t { NONE, VOLUME_UP, MUTE };
+ * BitsButtonActionMap<uint16_t> normal(buttons, {
+ *     {"btn1", BitsButtonEvent::CLICK_FINISH, VOLUME_UP},
+ *     {"btn1_btn2", BitsButtonEvent::LONG_PRESS_START, MUTE}});
+ * @endcode
+ */
+template <typename Command = uint16_t> class BitsButtonActionMap {
+public:
+  constexpr static size_t EVENT_TYPE_COUNT =
+      static_cast<size_t>(BitsButtonEvent::LINE_FAULT) + 1;
+
+  /**
+   * @brief Build the table from bindings
+   * @param buttons Module whose aliases are resolved
+   * @param bindings Bindings, later ones override earlier ones
+   */
+  template <typename ButtonModule>
+  BitsButtonActionMap(
+      const ButtonModule &buttons,
+      std::initializer_list<BitsButtonActionBinding<Command>> bindings) {
+    for (const auto &binding : bindings) {
+      auto index = buttons.FindLogicIndex(binding.key_alias);
+      ASSERT(index != BITS_BTN_INVALID_INDEX);
+      if (index != BITS_BTN_INVALID_INDEX) {
+        table_[index][static_cast<size_t>(binding.event)] = binding.command;
+      }
+    }
+  }
+
+  /**
+   * @brief Command bound to a button event
+   * @param logic_index Button index from ButtonEventResult::logic_index
+   * @param event Event type
+   * @return Bound command, or Command{} if none
+   */
+  Command Lookup(uint8_t logic_index, BitsButtonEvent event) const {
+    if (logic_index >= BITS_BTN_MAX_TOTAL) {
+      return Command{};
+    }
+    return table_[logic_index][static_cast<size_t>(event)];
+  }
+
+private:
+  std::array<std::array<Command, EVENT_TYPE_COUNT>, BITS_BTN_MAX_TOTAL>
+      table_{}; ///< Commands by logic index and event type
+};
+
+/**
+ * @brief Translates popped events through the active action table
+ * @tparam Command Command ID type or handler function pointer
+ * @note Switching modes is a single pointer store, safe while another
+ * thread dispatches.
+ */
+template <typename Command = uint16_t> class BitsButtonActionDispatcher {
+public:
+  using Map = BitsButtonActionMap<Command>;
+
+  /**
+   * @brief Construct with an initial table
+   * @param map Active table, or nullptr to map every event to Command{}
+   */
+  explicit BitsButtonActionDispatcher(const Map *map = nullptr) : map_(map) {}
+
+  /**
+   * @brief Make another table (mode/layer) active
+   * @param map New table, or nullptr to disable all actions
+   */
+  void SetMap(const Map *map) { map_.store(map, std::memory_order_release); }
+
+  /**
+   * @brief Command for an event popped from a BasicBitsButtonXR queue
+   * @param result Event result
+   * @return Bound command of the active table, or Command{} if none
+   */
+  template <typename Result> Command Dispatch(const Result &result) const {
+    const Map *map = map_.load(std::memory_order_acquire);
+    return map ? map->Lookup(result.logic_index, result.event_type) : Command{};
+  }
+
+private:
+  std::atomic<const Map *> map_; ///< Active table
+};
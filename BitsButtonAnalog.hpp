@@ -0,0 +1,150 @@
+#pragma once
+
+#include "BitsButtonXR.hpp"
+
+/**
+ * @brief Configuration of one virtual button driven by an analog axis
+ *
+ * A threshold with press_value >= release_value fires when the axis rises
+ * (trigger pulled), one with press_value < release_value when it falls
+ * (stick pushed to the negative side). Several thresholds may share an axis.
+ */
+struct BitsButtonAnalogThresholdConfig {
+  const char *key_alias; ///< EXTERNAL single button driven by this threshold
+  uint8_t axis;          ///< Index of the axis in the sample array
+  int32_t press_value;   ///< Axis value that presses the button
+  int32_t release_value; ///< Axis value that releases it again
+  uint8_t levels = 0; ///< Pressure levels 1..levels reported while pressed
+                      ///< (0 reports none)
+  int32_t full_value = 0; ///< Axis value of the top level
+};
+
+/**
+ * @brief Analog axis input source for BasicBitsButtonXR
+ * @tparam ButtonModule BasicBitsButtonXR instantiation to feed
+ * @tparam MAX_THRESHOLDS Threshold capacity
+ *
+ * Compares axis samples (triggers, joysticks) against press and release
+ * values with hysteresis and hands the resulting mask to
+ * UpdateExternalInputs(), so analog buttons debounce, combine and emit
+ * events like GPIO keys. Thresholds with levels also quantize the axis
+ * between press_value and full_value and pass the level through
+ * UpdateExternalLevel(), which needs ENABLE_PRESSURE_LEVELS in the module
+ * traits. The aliases must be declared with InputSource::EXTERNAL.
+ */
+template <typename ButtonModule, size_t MAX_THRESHOLDS = BITS_BTN_MAX_SINGLES>
+class BitsButtonAnalogSource {
+public:
+  using ButtonMaskType = typename ButtonModule::ButtonMaskType;
+
+  /**
+   * @brief Construct an analog source bound to a button module
+   * @param buttons Button module that receives the mask
+   * @param thresholds Threshold configurations
+   */
+  BitsButtonAnalogSource(
+      ButtonModule &buttons,
+      std::initializer_list<BitsButtonAnalogThresholdConfig> thresholds)
+      : buttons_(buttons) {
+    ASSERT(thresholds.size() <= MAX_THRESHOLDS);
+
+    for (const auto &cfg : thresholds) {
+      auto index = buttons_.FindButtonIndex(cfg.key_alias);
+      ASSERT(index != BITS_BTN_INVALID_INDEX);
+
+      auto &th = thresholds_[threshold_count_];
+      th.index = index;
+      th.axis = cfg.axis;
+      th.rising = cfg.press_value >= cfg.release_value;
+      th.press_value = cfg.press_value;
+      th.release_value = cfg.release_value;
+      th.levels = cfg.levels;
+      th.full_value = cfg.full_value;
+      th.last_level = 0;
+      ASSERT(cfg.levels == 0 || (th.rising ? cfg.full_value > cfg.press_value
+                                           : cfg.full_value < cfg.press_value));
+
+      source_mask_ |= static_cast<ButtonMaskType>(1UL) << index;
+      threshold_count_++;
+    }
+  }
+
+  /**
+   * @brief Evaluate all thresholds on one set of axis samples
+   * @param axes Axis values, indexed by BitsButtonAnalogThresholdConfig::axis
+   * @note Call once per tick; all axes are handled in a single pass and a
+   * single UpdateExternalInputs() call.
+   */
+  void Process(const int32_t *axes) {
+    ButtonMaskType active_mask = active_mask_;
+
+    for (size_t i = 0; i < threshold_count_; ++i) {
+      auto &th = thresholds_[i];
+      int32_t value = axes[th.axis];
+      ButtonMaskType bit = static_cast<ButtonMaskType>(1UL) << th.index;
+      bool active = (active_mask & bit) != 0;
+
+      /* Threshold plus hysteresis, mirrored for falling axes */
+      int32_t limit = active ? th.release_value : th.press_value;
+      active = th.rising ? value >= limit : value <= limit;
+
+      if (active) {
+        active_mask |= bit;
+        if (th.levels > 0) {
+          uint8_t level = Quantize(th, value);
+          if (level != th.last_level) {
+            th.last_level = level;
+            buttons_.UpdateExternalLevel(th.index, level);
+          }
+        }
+      } else {
+        active_mask &= ~bit;
+      }
+    }
+
+    active_mask_ = active_mask;
+    buttons_.UpdateExternalInputs(active_mask, source_mask_);
+  }
+
+  /**
+   * @brief Get the undebounced mask of the last pass
+   */
+  ButtonMaskType GetActiveMask() const { return active_mask_; }
+
+private:
+  struct Threshold {
+    uint8_t index;         ///< Logic index of the virtual button
+    uint8_t axis;          ///< Axis sample index
+    bool rising;           ///< Pressed above press_value, else below
+    uint8_t levels;        ///< Pressure level count, 0 for none
+    uint8_t last_level;    ///< Level last handed to the module
+    int32_t press_value;   ///< Press point
+    int32_t release_value; ///< Release point
+    int32_t full_value;    ///< Top level point
+  };
+
+  /**
+   * @brief Map an axis value of a pressed threshold to 1..levels
+   */
+  static uint8_t Quantize(const Threshold &th, int32_t value) {
+    int64_t span = static_cast<int64_t>(th.full_value) - th.press_value;
+    int64_t travel = static_cast<int64_t>(value) - th.press_value;
+    if (!th.rising) {
+      span = -span;
+      travel = -travel;
+    }
+    if (travel <= 0) {
+      return 1;
+    }
+    if (travel >= span) {
+      return th.levels;
+    }
+    return static_cast<uint8_t>(1 + travel * th.levels / span);
+  }
+
+  ButtonModule &buttons_; ///< Module fed with the mask
+  std::array<Threshold, MAX_THRESHOLDS> thresholds_{}; ///< Thresholds
+  ButtonMaskType source_mask_ = 0; ///< All bits owned by this source
+  ButtonMaskType active_mask_ = 0; ///< Active state after hysteresis
+  size_t threshold_count_ = 0;     ///< Configured thresholds
+};
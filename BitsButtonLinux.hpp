@@ -0,0 +1,351 @@
+#pragma once
+
+#include "BitsButtonXR.hpp"
+
+#if defined(__linux__)
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <linux/gpio.h>
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+/**
+ * @brief Mapping of one Linux input code to a button
+ */
+struct BitsButtonLinuxKeyMap {
+  uint32_t code; ///< evdev key code (KEY_*, BTN_*) or GPIO line offset
+  const char *key_alias; ///< EXTERNAL single button driven by this code
+};
+
+/**
+ * @brief Event-driven Linux input source for BasicBitsButtonXR
+ * @tparam ButtonModule BasicBitsButtonXR instantiation to drive
+ * @tparam MAX_DEVICES Number of input file descriptors
+ *
+ * Reads batched key events from evdev devices (struct input_event) and GPIO
+ * character device line requests (struct gpio_v2_line_event), waiting on
+ * them with epoll alongside a timerfd armed at NextDeadline(). Every engine
+ * step goes through ProcessInputs() on CLOCK_MONOTONIC milliseconds, so no
+ * polling thread or LibXR::Timer runs. The mapped aliases must be declared
+ * with InputSource::EXTERNAL, and UpdateExternalInputs() must not be used
+ * on the same module.
+ *
+ * Any readable descriptor that yields event structs works, so a pipe or
+ * socketpair fed with input_event records can stand in for a device. A
+ * record split across reads is kept until its remaining bytes arrive.
+ */
+template <typename ButtonModule, size_t MAX_DEVICES = 4>
+class BitsButtonLinuxSource {
+public:
+  using ButtonMaskType = typename ButtonModule::ButtonMaskType;
+
+  enum class DeviceType : uint8_t {
+    EVDEV = 0,     ///< /dev/input/event*, EV_KEY events
+    GPIO_CDEV = 1, ///< Line request fd of /dev/gpiochip*, edge events
+  };
+
+  constexpr static size_t READ_BATCH = 64; ///< Events fetched per read()
+
+  /**
+   * @brief Create the epoll instance and the deadline timerfd
+   * @param buttons Button module to drive
+   */
+  explicit BitsButtonLinuxSource(ButtonModule &buttons) : buttons_(buttons) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    ASSERT(epoll_fd_ >= 0 && timer_fd_ >= 0);
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = TIMER_SLOT;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &ev);
+  }
+
+  /**
+   * @brief Close the epoll instance and the timerfd, device fds stay open
+   */
+  ~BitsButtonLinuxSource() {
+    close(timer_fd_);
+    close(epoll_fd_);
+  }
+
+  BitsButtonLinuxSource(const BitsButtonLinuxSource &) = delete;
+  BitsButtonLinuxSource &operator=(const BitsButtonLinuxSource &) = delete;
+
+  /**
+   * @brief Watch an input descriptor
+   * @param fd Opened evdev device or GPIO line request, owned by the caller
+   * @param type Event format read from fd
+   * @param keys Codes of interest and the buttons they drive
+   * @param active_low GPIO lines only: a falling edge means pressed
+   * @return Error code indicating success or failure
+   * @note evdev keys start from the EVIOCGKEY state when available, GPIO
+   * lines start released until their first edge.
+   */
+  LibXR::ErrorCode AddDevice(int fd, DeviceType type,
+                             std::initializer_list<BitsButtonLinuxKeyMap> keys,
+                             bool active_low = false) {
+    if (device_count_ >= MAX_DEVICES) {
+      return LibXR::ErrorCode::NO_MEM;
+    }
+
+    auto &dev = devices_[device_count_];
+    dev.fd = fd;
+    dev.type = type;
+    dev.active_low = active_low;
+    dev.open = true;
+    dev.key_count = 0;
+    dev.partial_len = 0;
+    for (const auto &key : keys) {
+      auto index = buttons_.FindButtonIndex(key.key_alias);
+      if (index == BITS_BTN_INVALID_INDEX) {
+        return LibXR::ErrorCode::NOT_FOUND;
+      }
+      if (dev.key_count >= BITS_BTN_MAX_SINGLES) {
+        return LibXR::ErrorCode::NO_MEM;
+      }
+      dev.codes[dev.key_count] = key.code;
+      dev.bits[dev.key_count] = static_cast<ButtonMaskType>(1UL) << index;
+      dev.key_count++;
+    }
+
+    if (type == DeviceType::EVDEV) {
+      uint8_t key_state[KEY_MAX / 8 + 1] = {};
+      if (ioctl(fd, EVIOCGKEY(sizeof(key_state)), key_state) >= 0) {
+        for (size_t i = 0; i < dev.key_count; ++i) {
+          uint32_t code = dev.codes[i];
+          if (code <= KEY_MAX && (key_state[code / 8] & (1U << (code % 8)))) {
+            input_mask_ |= dev.bits[i];
+          }
+        }
+      }
+    }
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = device_count_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+      return LibXR::ErrorCode::FAILED;
+    }
+
+    device_count_++;
+    return LibXR::ErrorCode::OK;
+  }
+
+  /**
+   * @brief Wait for input or the next deadline and run the engine
+   * @param timeout_ms Longest wait, -1 to wait until something happens
+   * @return OK; NOT_FOUND when a device hung up, reached end of file or
+   * failed and was removed; FAILED when epoll_wait reports an error other
+   * than EINTR
+   * @note Call in a loop from the thread that owns the module. Input changes
+   * are processed at once when the previous step is at least one tick old,
+   * otherwise at the next tick, so debouncing keeps its time base. A removed
+   * device releases its buttons and is no longer waited on, see
+   * IsDeviceOpen().
+   */
+  LibXR::ErrorCode Run(int timeout_ms = -1) {
+    epoll_event ready[MAX_DEVICES + 1];
+    int count = epoll_wait(epoll_fd_, ready, MAX_DEVICES + 1, timeout_ms);
+    if (count < 0) {
+      return errno == EINTR ? LibXR::ErrorCode::OK : LibXR::ErrorCode::FAILED;
+    }
+
+    auto result = LibXR::ErrorCode::OK;
+    bool due = false;
+    ButtonMaskType old_mask = input_mask_;
+    for (int i = 0; i < count; ++i) {
+      if (ready[i].data.u32 == TIMER_SLOT) {
+        uint64_t expirations = 0;
+        ssize_t len = read(timer_fd_, &expirations, sizeof(expirations));
+        UNUSED(len);
+        due = true;
+      } else if (!ReadDevice(devices_[ready[i].data.u32], ready[i].events)) {
+        RemoveDevice(devices_[ready[i].data.u32]);
+        result = LibXR::ErrorCode::NOT_FOUND;
+      }
+    }
+
+    uint32_t now = NowMs();
+    if (input_mask_ != old_mask && !due) {
+      uint32_t next_tick = last_step_ + ButtonModule::TICK_INTERVAL_MS;
+      if (stepped_ && static_cast<int32_t>(next_tick - now) > 0) {
+        ArmTimer(next_tick, now);
+        return result;
+      }
+      due = true;
+    }
+
+    if (due) {
+      Step(now);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Current raw level mask of all watched codes
+   */
+  ButtonMaskType GetInputMask() const { return input_mask_; }
+
+  /**
+   * @brief Check whether a descriptor is still watched
+   * @param fd Descriptor passed to AddDevice()
+   * @return False if it was never added or Run() removed it
+   */
+  bool IsDeviceOpen(int fd) const {
+    for (size_t i = 0; i < device_count_; ++i) {
+      if (devices_[i].fd == fd && devices_[i].open) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  constexpr static uint32_t TIMER_SLOT = MAX_DEVICES; ///< epoll tag of timer_fd_
+
+  /// Largest event record of any DeviceType
+  constexpr static size_t RECORD_MAX =
+      sizeof(input_event) > sizeof(gpio_v2_line_event)
+          ? sizeof(input_event)
+          : sizeof(gpio_v2_line_event);
+
+  struct Device {
+    int fd;                ///< Caller owned descriptor
+    DeviceType type;       ///< Event format
+    bool active_low;       ///< GPIO falling edge means pressed
+    bool open;             ///< Still registered with epoll
+    uint8_t key_count;     ///< Used codes/bits entries
+    uint8_t partial_len;   ///< Bytes of an incomplete record in partial
+    std::array<uint32_t, BITS_BTN_MAX_SINGLES> codes;   ///< Watched codes
+    std::array<ButtonMaskType, BITS_BTN_MAX_SINGLES> bits; ///< Button bits
+    std::array<uint8_t, RECORD_MAX> partial; ///< Head of a split record
+  };
+
+  /**
+   * @brief Read one batch of events and apply them to input_mask_
+   * @param events epoll flags reported for the descriptor
+   * @return False if the device hung up, reached end of file or failed
+   */
+  bool ReadDevice(Device &dev, uint32_t events) {
+    if ((events & EPOLLIN) == 0) {
+      return (events & (EPOLLHUP | EPOLLERR)) == 0;
+    }
+
+    size_t record = dev.type == DeviceType::EVDEV
+                        ? sizeof(input_event)
+                        : sizeof(gpio_v2_line_event);
+    uint8_t buffer[READ_BATCH * RECORD_MAX];
+    std::memcpy(buffer, dev.partial.data(), dev.partial_len);
+    ssize_t len = read(dev.fd, buffer + dev.partial_len,
+                       READ_BATCH * record - dev.partial_len);
+    if (len < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    if (len == 0) {
+      return false;
+    }
+
+    size_t total = dev.partial_len + static_cast<size_t>(len);
+    size_t whole = total - total % record;
+    for (size_t offset = 0; offset < whole; offset += record) {
+      if (dev.type == DeviceType::EVDEV) {
+        input_event event;
+        std::memcpy(&event, buffer + offset, sizeof(event));
+        /* Autorepeat (value 2) is left to the engine's long press */
+        if (event.type == EV_KEY && event.value != 2) {
+          ApplyLevel(dev, event.code, event.value != 0);
+        }
+      } else {
+        gpio_v2_line_event event;
+        std::memcpy(&event, buffer + offset, sizeof(event));
+        bool high = event.id == GPIO_V2_LINE_EVENT_RISING_EDGE;
+        ApplyLevel(dev, event.offset, high != dev.active_low);
+      }
+    }
+
+    dev.partial_len = static_cast<uint8_t>(total - whole);
+    std::memcpy(dev.partial.data(), buffer + whole, dev.partial_len);
+    return true;
+  }
+
+  /**
+   * @brief Stop watching a dead device and release its buttons
+   */
+  void RemoveDevice(Device &dev) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, dev.fd, nullptr);
+    dev.open = false;
+    dev.partial_len = 0;
+    for (size_t i = 0; i < dev.key_count; ++i) {
+      input_mask_ &= ~dev.bits[i];
+    }
+  }
+
+  void ApplyLevel(const Device &dev, uint32_t code, bool active) {
+    for (size_t i = 0; i < dev.key_count; ++i) {
+      if (dev.codes[i] == code) {
+        input_mask_ = active ? (input_mask_ | dev.bits[i])
+                             : (input_mask_ & ~dev.bits[i]);
+        return;
+      }
+    }
+  }
+
+  /**
+   * @brief Run one engine step and arm the timer at the next deadline
+   */
+  void Step(uint32_t now) {
+    buttons_.ProcessInputs(input_mask_, now);
+    last_step_ = now;
+    stepped_ = true;
+
+    uint32_t deadline = buttons_.NextDeadline();
+    if (deadline == ButtonModule::DEADLINE_NEVER) {
+      itimerspec off = {};
+      timerfd_settime(timer_fd_, 0, &off, nullptr);
+      return;
+    }
+
+    /* Never step faster than the engine's tick */
+    uint32_t next_tick = now + ButtonModule::TICK_INTERVAL_MS;
+    if (static_cast<int32_t>(deadline - next_tick) < 0) {
+      deadline = next_tick;
+    }
+    ArmTimer(deadline, now);
+  }
+
+  void ArmTimer(uint32_t deadline, uint32_t now) {
+    int64_t delay_ns =
+        static_cast<int64_t>(static_cast<int32_t>(deadline - now)) * 1000000;
+    if (delay_ns <= 0) {
+      delay_ns = 1; // Zero would disarm the timer
+    }
+    itimerspec spec = {};
+    spec.it_value.tv_sec = static_cast<time_t>(delay_ns / 1000000000);
+    spec.it_value.tv_nsec = static_cast<long>(delay_ns % 1000000000);
+    timerfd_settime(timer_fd_, 0, &spec, nullptr);
+  }
+
+  static uint32_t NowMs() {
+    timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint32_t>(static_cast<uint64_t>(ts.tv_sec) * 1000 +
+                                 static_cast<uint64_t>(ts.tv_nsec) / 1000000);
+  }
+
+  ButtonModule &buttons_;                    ///< Driven module
+  int epoll_fd_ = -1;                        ///< Waits on devices and timer
+  int timer_fd_ = -1;                        ///< Armed at NextDeadline()
+  std::array<Device, MAX_DEVICES> devices_{}; ///< Watched descriptors
+  uint8_t device_count_ = 0;                 ///< Used devices_ slots
+  ButtonMaskType input_mask_ = 0;            ///< Raw levels of mapped codes
+  uint32_t last_step_ = 0;                   ///< Time of the last step
+  bool stepped_ = false;                     ///< last_step_ is valid
+};
+
+#endif
@@ -0,0 +1,415 @@
+#pragma once
+
+#include "BitsButtonXR.hpp"
+
+#if defined(__linux__)
+
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief Process independent copy of a ButtonEventResult
+ */
+struct BitsButtonShmEvent {
+  uint64_t sequence;         ///< Event number since the ring was created
+  uint32_t system_tick;      ///< System tick when event was generated
+  uint32_t state_bits;       ///< Click history of the button
+  uint16_t long_press_count; ///< Count of long press periods triggered
+  uint8_t event_type;        ///< BitsButtonEvent value
+  uint8_t velocity;          ///< Strike velocity, 0 if none
+  char key_alias[24];        ///< Button name, truncated and terminated
+};
+
+namespace BitsButtonDetail {
+
+constexpr uint32_t SHM_MAGIC = 0x42425352; ///< "BBSR"
+constexpr uint32_t SHM_VERSION = 1;
+
+/**
+ * @brief One ring slot, guarded by its own sequence (seqlock)
+ * @note seq is 0 while the writer fills the slot, event number + 1 after.
+ */
+struct ShmSlot {
+  std::atomic<uint64_t> seq;
+  BitsButtonShmEvent event;
+};
+
+/**
+ * @brief Shared memory layout, followed by capacity ShmSlot entries
+ */
+struct ShmHeader {
+  uint32_t magic;                   ///< SHM_MAGIC once initialized
+  uint32_t version;                 ///< SHM_VERSION
+  uint32_t capacity;                ///< Slot count, power of two
+  uint32_t slot_size;               ///< sizeof(ShmSlot) of the writer
+  std::atomic<uint64_t> write_seq;  ///< Events published so far
+  std::atomic<uint32_t> futex_word; ///< Bumped on publish, futex target
+  std::atomic<uint32_t> waiters;    ///< Readers blocked in Wait()
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Shared memory ring needs address-free 64-bit atomics");
+
+inline size_t ShmSize(uint32_t capacity) {
+  return sizeof(ShmHeader) + sizeof(ShmSlot) * capacity;
+}
+
+inline ShmSlot *ShmSlots(ShmHeader *header) {
+  return reinterpret_cast<ShmSlot *>(header + 1);
+}
+
+} // namespace BitsButtonDetail
+
+/**
+ * @brief Single-producer broadcast ring in shared memory
+ *
+ * The ring lives in a memfd (pass the fd to other processes) or in a named
+ * POSIX shared memory object under /dev/shm. Publishing never blocks and
+ * never waits for readers: a slow reader loses the oldest events and sees
+ * the gap through its sequence numbers. No syscall is made per event unless
+ * a reader sleeps in Wait(). A named object outlives the writer until
+ * Unlink() removes its name; mapped readers keep working after that.
+ */
+class BitsButtonShmWriter {
+public:
+  BitsButtonShmWriter() = default;
+  ~BitsButtonShmWriter() {
+    if (header_) {
+      munmap(header_, BitsButtonDetail::ShmSize(header_->capacity));
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  BitsButtonShmWriter(const BitsButtonShmWriter &) = delete;
+  BitsButtonShmWriter &operator=(const BitsButtonShmWriter &) = delete;
+
+  /**
+   * @brief Create and map the ring
+   * @param name POSIX shared memory name ("/buttons"), or nullptr for an
+   * anonymous memfd shared by passing Fd()
+   * @param capacity Slot count, power of two
+   * @return Error code indicating success or failure
+   */
+  LibXR::ErrorCode Create(const char *name, uint32_t capacity) {
+    if (header_ || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+      return LibXR::ErrorCode::ARG_ERR;
+    }
+
+    if (name && strlen(name) >= sizeof(name_)) {
+      return LibXR::ErrorCode::ARG_ERR;
+    }
+
+    fd_ = name ? shm_open(name, O_CREAT | O_RDWR, 0644)
+               : memfd_create("bits_button", MFD_CLOEXEC);
+    if (fd_ < 0) {
+      return LibXR::ErrorCode::INIT_ERR;
+    }
+    if (name) {
+      strcpy(name_, name);
+    }
+
+    size_t size = BitsButtonDetail::ShmSize(capacity);
+    void *map = MAP_FAILED;
+    if (ftruncate(fd_, static_cast<off_t>(size)) == 0) {
+      map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    }
+    if (map == MAP_FAILED) {
+      Unlink();
+      close(fd_);
+      fd_ = -1;
+      return LibXR::ErrorCode::NO_MEM;
+    }
+
+    header_ = new (map) BitsButtonDetail::ShmHeader();
+    auto *slots = BitsButtonDetail::ShmSlots(header_);
+    for (uint32_t i = 0; i < capacity; ++i) {
+      new (&slots[i]) BitsButtonDetail::ShmSlot();
+      slots[i].seq.store(0, std::memory_order_relaxed);
+    }
+    header_->capacity = capacity;
+    header_->slot_size = sizeof(BitsButtonDetail::ShmSlot);
+    header_->version = BitsButtonDetail::SHM_VERSION;
+    header_->write_seq.store(0, std::memory_order_relaxed);
+    header_->futex_word.store(0, std::memory_order_relaxed);
+    header_->waiters.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = BitsButtonDetail::SHM_MAGIC;
+    return LibXR::ErrorCode::OK;
+  }
+
+  /**
+   * @brief Descriptor of the shared memory, for passing a memfd
+   */
+  int Fd() const { return fd_; }
+
+  /**
+   * @brief Remove the name of a named ring from /dev/shm
+   * @return OK, NOT_FOUND for a memfd ring or a name already removed
+   * @note Call once all readers opened the ring, or at shutdown. The
+   * mapping of the writer and of attached readers stays valid.
+   */
+  LibXR::ErrorCode Unlink() {
+    if (name_[0] == '\0') {
+      return LibXR::ErrorCode::NOT_FOUND;
+    }
+    int result = shm_unlink(name_);
+    name_[0] = '\0';
+    return result == 0 ? LibXR::ErrorCode::OK : LibXR::ErrorCode::NOT_FOUND;
+  }
+
+  /**
+   * @brief Append one event, overwriting the oldest slot when full
+   * @param event Event to publish, its sequence field is assigned here
+   */
+  void Publish(const BitsButtonShmEvent &event) {
+    ASSERT(header_);
+    uint64_t seq = header_->write_seq.load(std::memory_order_relaxed);
+    auto &slot =
+        BitsButtonDetail::ShmSlots(header_)[seq & (header_->capacity - 1)];
+
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = event;
+    slot.event.sequence = seq;
+    slot.seq.store(seq + 1, std::memory_order_release);
+    header_->write_seq.store(seq + 1, std::memory_order_release);
+
+    header_->futex_word.fetch_add(1, std::memory_order_release);
+    if (header_->waiters.load(std::memory_order_acquire) != 0) {
+      syscall(SYS_futex, &header_->futex_word, FUTEX_WAKE, INT_MAX, nullptr,
+              nullptr, 0);
+    }
+  }
+
+private:
+  int fd_ = -1;                                  ///< memfd or shm object
+  BitsButtonDetail::ShmHeader *header_ = nullptr; ///< Mapped ring
+  char name_[NAME_MAX + 1] = {};                  ///< Name until Unlink()
+};
+
+/**
+ * @brief Reader side of a BitsButtonShmWriter ring, one per consumer
+ */
+class BitsButtonShmReader {
+public:
+  BitsButtonShmReader() = default;
+  ~BitsButtonShmReader() {
+    if (header_) {
+      munmap(header_, map_size_);
+    }
+  }
+
+  BitsButtonShmReader(const BitsButtonShmReader &) = delete;
+  BitsButtonShmReader &operator=(const BitsButtonShmReader &) = delete;
+
+  /**
+   * @brief Map a named ring created by another process
+   * @param name POSIX shared memory name passed to Create()
+   * @return Error code indicating success or failure
+   */
+  LibXR::ErrorCode Open(const char *name) {
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+      fd = shm_open(name, O_RDONLY, 0);
+    }
+    if (fd < 0) {
+      return LibXR::ErrorCode::NOT_FOUND;
+    }
+    auto result = Attach(fd);
+    close(fd);
+    return result;
+  }
+
+  /**
+   * @brief Map a ring from a descriptor (memfd received from the writer)
+   * @param fd Descriptor, may be closed afterwards
+   * @return Error code indicating success or failure
+   * @note Reading starts with the next published event.
+   */
+  LibXR::ErrorCode Attach(int fd) {
+    struct stat st = {};
+    if (header_ || fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(BitsButtonDetail::ShmHeader)) {
+      return LibXR::ErrorCode::ARG_ERR;
+    }
+
+    /* Read-write mapping: waiters and the futex word live in the header */
+    map_size_ = static_cast<size_t>(st.st_size);
+    void *map =
+        mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+      map = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+      read_only_ = true;
+    }
+    if (map == MAP_FAILED) {
+      return LibXR::ErrorCode::NO_MEM;
+    }
+
+    header_ = static_cast<BitsButtonDetail::ShmHeader *>(map);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header_->magic != BitsButtonDetail::SHM_MAGIC ||
+        header_->version != BitsButtonDetail::SHM_VERSION ||
+        header_->slot_size != sizeof(BitsButtonDetail::ShmSlot) ||
+        BitsButtonDetail::ShmSize(header_->capacity) > map_size_) {
+      munmap(header_, map_size_);
+      header_ = nullptr;
+      return LibXR::ErrorCode::STATE_ERR;
+    }
+
+    next_seq_ = header_->write_seq.load(std::memory_order_acquire);
+    return LibXR::ErrorCode::OK;
+  }
+
+  /**
+   * @brief Take the next event without any syscall
+   * @param out_event Destination of the event
+   * @return True if an event was read, false if none is pending
+   * @note When the writer lapped this reader, reading resumes at the oldest
+   * event still held and the skipped count is added to Lost().
+   */
+  bool Read(BitsButtonShmEvent &out_event) {
+    ASSERT(header_);
+    const uint64_t capacity = header_->capacity;
+    auto *slots = BitsButtonDetail::ShmSlots(header_);
+
+    while (true) {
+      uint64_t written = header_->write_seq.load(std::memory_order_acquire);
+      if (next_seq_ == written) {
+        return false;
+      }
+      if (written - next_seq_ > capacity) {
+        lost_ += written - capacity - next_seq_;
+        next_seq_ = written - capacity;
+      }
+
+      auto &slot = slots[next_seq_ & (capacity - 1)];
+      uint64_t before = slot.seq.load(std::memory_order_acquire);
+      if (before == next_seq_ + 1) {
+        out_event = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == before) {
+          next_seq_++;
+          return true;
+        }
+      }
+      /* Slot rewritten while copying, recheck the lap */
+    }
+  }
+
+  /**
+   * @brief Block until an event is pending
+   * @param timeout_ms Longest wait, -1 for no limit
+   * @return True if an event is pending
+   * @note Needs a read-write mapping to register as a waiter; read-only
+   * readers fall back to polling.
+   */
+  bool Wait(int timeout_ms) {
+    ASSERT(header_);
+    uint32_t word = header_->futex_word.load(std::memory_order_acquire);
+    if (Pending()) {
+      return true;
+    }
+    if (read_only_) {
+      return false;
+    }
+
+    timespec ts = {};
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = static_cast<long>(timeout_ms % 1000) * 1000000;
+    header_->waiters.fetch_add(1, std::memory_order_acq_rel);
+    syscall(SYS_futex, &header_->futex_word, FUTEX_WAIT, word,
+            timeout_ms < 0 ? nullptr : &ts, nullptr, 0);
+    header_->waiters.fetch_sub(1, std::memory_order_acq_rel);
+    return Pending();
+  }
+
+  /**
+   * @brief Check whether an unread event exists
+   */
+  bool Pending() const {
+    return header_->write_seq.load(std::memory_order_acquire) != next_seq_;
+  }
+
+  /**
+   * @brief Events overwritten before this reader got to them
+   */
+  uint64_t Lost() const { return lost_; }
+
+private:
+  BitsButtonDetail::ShmHeader *header_ = nullptr; ///< Mapped ring
+  size_t map_size_ = 0;                           ///< Mapped length
+  bool read_only_ = false;  ///< No waiter registration possible
+  uint64_t next_seq_ = 0;   ///< Next event number to read
+  uint64_t lost_ = 0;       ///< Skipped by overruns
+};
+
+/**
+ * @brief Export stage from a BasicBitsButtonXR instance to a shared ring
+ * @tparam ButtonModule BasicBitsButtonXR instantiation with event subscribers
+ *
+ * Takes one filtered consumer queue of the module and copies its events
+ * into the ring. Call Pump() from the thread that drives the module, e.g.
+ * after every BitsButtonLinuxSource::Run().
+ */
+template <typename ButtonModule> class BitsButtonShmExporter {
+public:
+  /**
+   * @brief Subscribe to the module
+   * @param buttons Module to export
+   * @param writer Created ring
+   * @param index_mask Buttons to export, all by default
+   * @param type_mask Event types to export, all by default
+   * @param capacity Depth of the module-side queue between two Pump() calls
+   */
+  BitsButtonShmExporter(ButtonModule &buttons, BitsButtonShmWriter &writer,
+                        typename ButtonModule::ButtonIndexMask index_mask =
+                            ~typename ButtonModule::ButtonIndexMask(0),
+                        uint32_t type_mask = UINT32_MAX, size_t capacity = 16)
+      : buttons_(buttons), writer_(writer),
+        queue_(buttons.CreateEventQueue(index_mask, type_mask, capacity)) {
+    static_assert(ButtonModule::HAS_SUBSCRIBERS,
+                  "Exporting needs MAX_EVENT_SUBSCRIBERS > 0");
+    ASSERT(queue_ != ButtonModule::INVALID_SUBSCRIBER);
+  }
+
+  /**
+   * @brief Move all queued events into the ring
+   * @return Number of events published
+   */
+  size_t Pump() {
+    typename ButtonModule::ButtonEventResult res;
+    size_t count = 0;
+    while (buttons_.GetEventResult(queue_, res)) {
+      BitsButtonShmEvent event = {};
+      event.system_tick = res.system_tick;
+      event.state_bits = res.state_bits;
+      event.long_press_count = res.long_press_count;
+      event.event_type = static_cast<uint8_t>(res.event_type);
+      event.velocity = res.velocity;
+      if (res.key_alias) {
+        strncpy(event.key_alias, res.key_alias, sizeof(event.key_alias) - 1);
+      }
+      writer_.Publish(event);
+      buttons_.ReleaseEventPayload(res);
+      count++;
+    }
+    return count;
+  }
+
+private:
+  ButtonModule &buttons_;                     ///< Exported module
+  BitsButtonShmWriter &writer_;               ///< Destination ring
+  typename ButtonModule::SubscriberId queue_; ///< Module-side queue
+};
+
+#endif
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "BitsButtonXR.hpp"
+
+/**
+ * @brief Configuration of one self-capacitance touch pad
+ */
+struct BitsButtonTouchPadConfig {
+  const char *key_alias; ///< EXTERNAL single button driven by this pad
+  uint16_t touch_threshold; ///< Counts above baseline that report a touch
+  uint16_t
+      release_threshold; ///< Counts above baseline that keep a touch active
+};
+
+/**
+ * @brief Touch pad input source for BasicBitsButtonXR
+ * @tparam ButtonModule BasicBitsButtonXR instantiation to feed
+ * @tparam MAX_PADS Pad capacity
+ *
+ * Takes raw count samples (higher count = finger present), tracks a per-pad
+ * baseline with slow drift compensation and applies threshold plus
+ * hysteresis. The resulting mask is handed to UpdateExternalInputs(), so the
+ * pads go through the same debounce, combined and event pipeline as GPIO keys.
+ * The pads' aliases must be declared with InputSource::EXTERNAL.
+ */
+template <typename ButtonModule, size_t MAX_PADS = BITS_BTN_MAX_SINGLES>
+class BitsButtonTouchSource {
+public:
+  using ButtonMaskType = typename ButtonModule::ButtonMaskType;
+
+  constexpr static uint8_t BASELINE_FRAC_BITS =
+      8; ///< Fixed point fraction bits of the baseline
+  constexpr static uint8_t DRIFT_SHIFT =
+      8; ///< Baseline follows 1/256 of the error per released sample
+  constexpr static uint8_t RECOVER_SHIFT =
+      2; ///< Faster tracking when raw counts fall below the baseline
+
+  /**
+   * @brief Construct a touch source bound to a button module
+   * @param buttons Button module that receives the touch mask
+   * @param pads Pad configurations, sample i belongs to pad i
+   */
+  BitsButtonTouchSource(ButtonModule &buttons,
+                        std::initializer_list<BitsButtonTouchPadConfig> pads)
+      : buttons_(buttons) {
+    ASSERT(pads.size() <= MAX_PADS);
+
+    for (const auto &pad : pads) {
+      auto index = buttons_.FindButtonIndex(pad.key_alias);
+      ASSERT(index != BITS_BTN_INVALID_INDEX);
+      ASSERT(pad.release_threshold <= pad.touch_threshold);
+
+      pad_bits_[pad_count_] = static_cast<ButtonMaskType>(1UL) << index;
+      touch_threshold_[pad_count_] = pad.touch_threshold;
+      release_threshold_[pad_count_] = pad.release_threshold;
+      source_mask_ |= pad_bits_[pad_count_];
+      pad_count_++;
+    }
+  }
+
+  /**
+   * @brief Process one scan of all pads in a single pass
+   * @param raw_counts Raw counts, one per configured pad
+   */
+  void Process(const uint16_t *raw_counts) {
+    ButtonMaskType touch_mask = touch_mask_;
+
+    for (size_t i = 0; i < pad_count_; ++i) {
+      int32_t raw_q = static_cast<int32_t>(raw_counts[i])
+                      << BASELINE_FRAC_BITS;
+      if (!calibrated_) {
+        baseline_q_[i] = raw_q;
+      }
+
+      int32_t error_q = raw_q - baseline_q_[i];
+      int32_t delta = error_q >> BASELINE_FRAC_BITS;
+      bool touched = (touch_mask & pad_bits_[i]) != 0;
+
+      /* Threshold plus hysteresis */
+      touched = touched ? delta >= release_threshold_[i]
+                        : delta >= touch_threshold_[i];
+
+      if (touched) {
+        touch_mask |= pad_bits_[i];
+      } else {
+        touch_mask &= ~pad_bits_[i];
+
+        /* Drift compensation only while released, so a finger is never
+         * absorbed into the baseline */
+        baseline_q_[i] += error_q >> (error_q < 0 ? RECOVER_SHIFT : DRIFT_SHIFT);
+      }
+    }
+
+    calibrated_ = true;
+    touch_mask_ = touch_mask;
+    buttons_.UpdateExternalInputs(touch_mask, source_mask_);
+  }
+
+  /**
+   * @brief Restart baseline tracking from the next scan
+   */
+  void Recalibrate() { calibrated_ = false; }
+
+  /**
+   * @brief Get the tracked baseline of a pad
+   * @param pad Pad index
+   * @return Baseline in raw counts
+   */
+  uint16_t GetBaseline(size_t pad) const {
+    ASSERT(pad < pad_count_);
+    return static_cast<uint16_t>(baseline_q_[pad] >> BASELINE_FRAC_BITS);
+  }
+
+  /**
+   * @brief Get the undebounced touch mask of the last scan
+   */
+  ButtonMaskType GetTouchMask() const { return touch_mask_; }
+
+private:
+  ButtonModule &buttons_; ///< Module fed with the touch mask
+  std::array<ButtonMaskType, MAX_PADS> pad_bits_{}; ///< Button bit per pad
+  std::array<uint16_t, MAX_PADS> touch_threshold_{};   ///< Touch threshold
+  std::array<uint16_t, MAX_PADS> release_threshold_{}; ///< Release threshold
+  std::array<int32_t, MAX_PADS>
+      baseline_q_{};               ///< Baselines, BASELINE_FRAC_BITS fixed point
+  ButtonMaskType source_mask_ = 0; ///< All bits owned by this source
+  ButtonMaskType touch_mask_ = 0;  ///< Touch state after hysteresis
+  size_t pad_count_ = 0;           ///< Configured pads
+  bool calibrated_ = false;        ///< Baselines seeded from a scan
+};
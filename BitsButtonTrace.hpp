@@ -0,0 +1,147 @@
+#pragma once
+
+#include "BitsButtonXR.hpp"
+#include <cstdio>
+
+/**
+ * @brief Trace ring buffer with Chrome trace-event export
+ * @tparam CAPACITY Number of trace points kept, oldest are overwritten
+ *
+ * Select it as the tracer of a traits struct and attach an instance:
+ * @code
+ * struct TracedTraits : BitsButtonDefaultTraits {
+ *   using Tracer = BitsButtonTraceBuffer<1024>;
+ * };
+ * BitsButtonTraceBuffer<1024> trace;
+ * buttons.SetTracer(&trace);
+ * @endcode
+ * After a run or a replay through ProcessInputs(), ExportChromeTrace()
+ * writes JSON that chrome://tracing and Perfetto open as a timeline: engine
+ * ticks as slices on lane 0, every other point as an instant on the lane of
+ * its button (logic index + 1).
+ */
+template <size_t CAPACITY> class BitsButtonTraceBuffer {
+public:
+  static_assert(CAPACITY > 0, "Trace buffer capacity must be positive");
+
+  static constexpr bool ENABLED = true;
+
+  struct Entry {
+    uint32_t time_us;           ///< Timebase microseconds
+    uint32_t value;             ///< Point specific value
+    BitsButtonTracePoint point; ///< What happened
+    uint8_t index;              ///< Logic index, or BITS_BTN_INVALID_INDEX
+  };
+
+  /**
+   * @brief Store one trace point
+   * @note Safe from the timer and from ISRs (WAKE points); entries are
+   * claimed with an atomic counter.
+   */
+  void Record(BitsButtonTracePoint point, uint8_t index, uint32_t value,
+              uint32_t time_us) {
+    uint32_t slot = written_.fetch_add(1, std::memory_order_relaxed);
+    entries_[slot % CAPACITY] = {time_us, value, point, index};
+  }
+
+  /**
+   * @brief Number of entries currently held
+   */
+  size_t Size() const {
+    uint32_t written = written_.load(std::memory_order_acquire);
+    return written < CAPACITY ? written : CAPACITY;
+  }
+
+  /**
+   * @brief Drop all entries
+   */
+  void Clear() { written_ = 0; }
+
+  /**
+   * @brief Entry by age
+   * @param i 0 is the oldest held entry
+   */
+  const Entry &At(size_t i) const {
+    ASSERT(i < Size());
+    uint32_t written = written_.load(std::memory_order_acquire);
+    uint32_t first = written < CAPACITY ? 0 : written - CAPACITY;
+    return entries_[(first + i) % CAPACITY];
+  }
+
+  /**
+   * @brief Write all held entries as a Chrome trace-event JSON document
+   * @param write Callable taking a null-terminated chunk of text
+   * @note Call while tracing is stopped; entries written concurrently may
+   * show up torn.
+   */
+  template <typename Writer> void ExportChromeTrace(Writer &&write) const {
+    char line[160];
+    write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    write("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+          "\"args\":{\"name\":\"engine\"}}");
+
+    for (size_t i = 0; i < Size(); ++i) {
+      const Entry &e = At(i);
+      unsigned tid =
+          e.index == BITS_BTN_INVALID_INDEX ? 0U : e.index + 1U;
+      switch (e.point) {
+      case BitsButtonTracePoint::TICK_BEGIN:
+      case BitsButtonTracePoint::TICK_END:
+        snprintf(line, sizeof(line),
+                 ",\n{\"name\":\"tick\",\"ph\":\"%c\",\"ts\":%lu,\"pid\":1,"
+                 "\"tid\":0,\"args\":{\"mask\":%lu}}",
+                 e.point == BitsButtonTracePoint::TICK_BEGIN ? 'B' : 'E',
+                 static_cast<unsigned long>(e.time_us),
+                 static_cast<unsigned long>(e.value));
+        break;
+      default:
+        snprintf(line, sizeof(line),
+                 ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lu,"
+                 "\"pid\":1,\"tid\":%u,\"args\":{\"value\":%lu}}",
+                 PointName(e.point), static_cast<unsigned long>(e.time_us),
+                 tid, static_cast<unsigned long>(e.value));
+        break;
+      }
+      write(line);
+    }
+
+    write("\n]}\n");
+  }
+
+  /**
+   * @brief Display name of a trace point
+   */
+  static const char *PointName(BitsButtonTracePoint point) {
+    switch (point) {
+    case BitsButtonTracePoint::TICK_BEGIN:
+      return "tick_begin";
+    case BitsButtonTracePoint::TICK_END:
+      return "tick_end";
+    case BitsButtonTracePoint::RAW_EDGE:
+      return "raw_edge";
+    case BitsButtonTracePoint::DEBOUNCED:
+      return "debounced";
+    case BitsButtonTracePoint::STATE:
+      return "state";
+    case BitsButtonTracePoint::COMBO_COMMIT:
+      return "combo_commit";
+    case BitsButtonTracePoint::SUPPRESS:
+      return "suppress";
+    case BitsButtonTracePoint::QUEUE_PUSH:
+      return "queue_push";
+    case BitsButtonTracePoint::QUEUE_POP:
+      return "queue_pop";
+    case BitsButtonTracePoint::WAKE:
+      return "wake";
+    case BitsButtonTracePoint::SLEEP:
+      return "sleep";
+    case BitsButtonTracePoint::QUEUE_DROP:
+      return "queue_drop";
+    }
+    return "unknown";
+  }
+
+private:
+  std::array<Entry, CAPACITY> entries_{}; ///< Ring storage
+  std::atomic<uint32_t> written_ = 0;     ///< Entries recorded so far
+};
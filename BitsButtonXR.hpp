@@ -44,17 +44,315 @@ depends: []
 #include "app_framework.hpp"
 #include "gpio.hpp"
 #include "libxr_def.hpp"
+#include "timebase.hpp"
 #include "timer.hpp"
 #include <atomic>
 #include <cstdint>
 #include <cstring>
+#include <type_traits>
 
 #define BITS_BTN_MAX_SINGLES 32
 #define BITS_BTN_MAX_COMBINED 16
 #define BITS_BTN_MAX_TOTAL (BITS_BTN_MAX_SINGLES + BITS_BTN_MAX_COMBINED)
 #define BITS_BTN_INVALID_INDEX 0xFF
 
-class BitsButtonXR : public LibXR::Application {
+enum class BitsButtonEvent : uint8_t {
+  PRESSED = 0,          ///< Button initially pressed
+  LONG_PRESS_START = 1, ///< Long press detected (after threshold)
+  LONG_PRESS_HOLD = 2,  ///< Periodic long press hold
+  RELEASED = 3,         ///< Button released
+  CLICK_FINISH = 4,     ///< Click followed by long press
+  SWITCH_ON = 5,        ///< Switch input turned on (level event)
+  SWITCH_OFF = 6,       ///< Switch input turned off (level event)
+  LINE_FAULT = 7,       ///< Line masked after an interrupt storm
+};
+
+/**
+ * @brief Bit of an event type inside a feature EVENT_MASK
+ * @param event Event type
+ * @return Single-bit mask for the event
+ */
+constexpr uint32_t BitsButtonEventBit(BitsButtonEvent event) {
+  return 1UL << static_cast<uint8_t>(event);
+}
+
+enum class BitsButtonTracePoint : uint8_t {
+  TICK_BEGIN = 0,   ///< Engine step starts, value = raw mask
+  TICK_END = 1,     ///< Engine step ends, value = logical mask
+  RAW_EDGE = 2,     ///< Raw input changed, value = new level
+  DEBOUNCED = 3,    ///< Debounced level confirmed, value = new level
+  STATE = 4,        ///< State machine transition, value = new state
+  COMBO_COMMIT = 5, ///< Combined button starts matching, value = its mask
+  SUPPRESS = 6,     ///< Single key cancelled by a combined button
+  QUEUE_PUSH = 7,   ///< Event queued, value = event type
+  QUEUE_POP = 8,    ///< Event taken by a consumer, value = event type
+  WAKE = 9,         ///< Polling started by an input, index = source
+  SLEEP = 10,       ///< Polling stopped
+  QUEUE_DROP = 11,  ///< Event rejected by a full queue, value = event type
+};
+
+/**
+ * @brief Tracer that records nothing, the default
+ * @note A tracer provides ENABLED and Record(point, index, value, time_us).
+ * With ENABLED false every trace point compiles out.
+ */
+struct BitsButtonNullTracer {
+  static constexpr bool ENABLED = false;
+  void Record(BitsButtonTracePoint, uint8_t, uint32_t, uint32_t) {}
+};
+
+/**
+ * @brief Default feature traits, every feature enabled
+ * @note Derive from this struct and shadow members to compile features out:
+ * @code
+ * struct TinyTraits : BitsButtonDefaultTraits {
+ *   static constexpr bool ENABLE_COMBINED = false;
+ *   static constexpr uint32_t EVENT_MASK =
+ *       BitsButtonEventBit(BitsButtonEvent::PRESSED) |
+ *       BitsButtonEventBit(BitsButtonEvent::RELEASED);
+ * };
+ * BasicBitsButtonXR<TinyTraits> buttons(hw, app, {...}, {});
+ * @endcode
+ */
+struct BitsButtonDefaultTraits {
+  static constexpr bool ENABLE_COMBINED = true; ///< Combined button support
+  static constexpr bool ENABLE_SUPPRESSION =
+      true; ///< Single key suppression by combined buttons
+  static constexpr bool ENABLE_CLICK_HISTORY =
+      true; ///< Binary click history in state_bits
+  static constexpr uint32_t EVENT_MASK =
+      BitsButtonEventBit(BitsButtonEvent::PRESSED) |
+      BitsButtonEventBit(BitsButtonEvent::LONG_PRESS_START) |
+      BitsButtonEventBit(BitsButtonEvent::LONG_PRESS_HOLD) |
+      BitsButtonEventBit(BitsButtonEvent::RELEASED) |
+      BitsButtonEventBit(BitsButtonEvent::CLICK_FINISH) |
+      BitsButtonEventBit(BitsButtonEvent::SWITCH_ON) |
+      BitsButtonEventBit(BitsButtonEvent::SWITCH_OFF) |
+      BitsButtonEventBit(BitsButtonEvent::LINE_FAULT); ///< Emitted events
+  static constexpr size_t MAX_VELOCITY_KEYS =
+      0; ///< Dual-contact velocity key capacity (0 compiles them out)
+  static constexpr bool ENABLE_WAKE_STATS =
+      false; ///< Wake attribution and awake time accounting
+  static constexpr uint16_t IDLE_SCAN_INTERVAL_MS =
+      50; ///< Idle polling period when GPIO_POLLED inputs exist
+  static constexpr bool ENABLE_TICKLESS_IDLE =
+      false; ///< Re-arm edge interrupts while awake and settled, so
+             ///< NextDeadline() may skip ticks of GPIO inputs
+  static constexpr uint16_t STORM_EDGE_LIMIT =
+      0; ///< Wake edges per STORM_WINDOW_MS that mask a line (0 disables)
+  static constexpr uint16_t STORM_WINDOW_MS = 1000; ///< Edge counting window
+  static constexpr uint16_t STORM_BACKOFF_MS =
+      500; ///< First masking period, doubled on every repeated storm
+  static constexpr uint16_t STORM_BACKOFF_MAX_MS =
+      8000; ///< Masking period limit, also the quiet time that resets it
+  static constexpr size_t MAX_EVENT_SUBSCRIBERS =
+      0; ///< Filtered consumer queues (0 compiles them out, max 8)
+  static constexpr size_t STATIC_EVENT_QUEUE_SIZE =
+      0; ///< In-object queue depth, power of two (0 keeps the heap queue)
+  static constexpr size_t MAX_LAYERS =
+      0; ///< Key layer capacity (0 compiles the layer stage out)
+  static constexpr uint32_t OVERLOAD_BUDGET_US =
+      0; ///< Tick duration counted as an overrun (0 disables the guard)
+  static constexpr uint16_t OVERLOAD_RECOVER_TICKS =
+      20; ///< Consecutive healthy ticks that end the degraded mode
+  static constexpr uint32_t OVERLOAD_SHED_EVENTS = BitsButtonEventBit(
+      BitsButtonEvent::LONG_PRESS_HOLD); ///< Events dropped while degraded
+  using Tracer = BitsButtonNullTracer; ///< Timeline trace sink
+  static constexpr uint16_t SLEEP_WAKE_COST_TICKS =
+      0; ///< Cost of a sleep/wake cycle in awake ticks (0 keeps the fixed
+         ///< sleep hysteresis)
+  static constexpr uint16_t ADAPTIVE_SLEEP_MAX_TICKS =
+      30; ///< Longest learned sleep hysteresis
+  static constexpr size_t PAYLOAD_POOL_SIZE =
+      0; ///< Extended payload slots, max 32 (0 compiles payloads out)
+  static constexpr uint32_t PAYLOAD_EVENTS =
+      BitsButtonEventBit(BitsButtonEvent::PRESSED) |
+      BitsButtonEventBit(BitsButtonEvent::RELEASED); ///< Events that attach
+                                                     ///< a payload
+  static constexpr size_t EVENT_HISTORY_SIZE =
+      0; ///< Recent events kept for CopyHistory (0 compiles it out)
+  static constexpr bool ENABLE_PRESSURE_LEVELS =
+      false; ///< Analog pressure level on PRESSED/LONG_PRESS_HOLD
+  static constexpr bool ENABLE_SAMPLE_TIMESTAMPS =
+      true; ///< ProcessSamples dates edges to their first sample
+  static constexpr bool ENABLE_QUEUE_STATS =
+      true; ///< Pushed/dropped counters of the event queues
+};
+
+namespace BitsButtonDetail {
+
+/* Optional per-button fields, empty (and folded by EBO) when disabled */
+
+template <bool ENABLE> struct ClickHistoryField {
+  uint32_t state_bits; ///< Click history (0b10, 0b1010...)
+};
+template <> struct ClickHistoryField<false> {};
+
+template <bool ENABLE> struct LongPressField {
+  uint16_t long_press_cnt; ///< Long press event triggered count
+};
+template <> struct LongPressField<false> {};
+
+template <bool ENABLE> struct PendingPressField {
+  bool is_suppressible;        ///< Whether this button participates in a
+                               ///< suppressible combined
+  uint32_t pending_press_tick; ///< Timestamp when button started waiting
+                               ///< for combined
+};
+template <> struct PendingPressField<false> {};
+
+template <bool ENABLE> struct PressTickField {
+  uint32_t press_tick; ///< Tick of the press that began the sequence
+};
+template <> struct PressTickField<false> {};
+
+template <bool ENABLE> struct StormGuardField {
+  uint16_t edge_count;   ///< Counted edges in the current storm window
+  uint16_t backoff_ms;   ///< Masking period of the next storm
+  uint32_t window_start; ///< Start of the storm window
+  uint32_t storm_until;  ///< End of the current masking period
+};
+template <> struct StormGuardField<false> {};
+
+/**
+ * @brief Single-producer multi-consumer ring with in-object storage
+ * @tparam Data Element type
+ * @tparam SIZE Capacity, must be a power of two
+ * @note Same Push/Pop/Peek interface as LibXR::LockFreeQueue, but never
+ * touches the heap. Head and tail run freely and are masked on access.
+ * Consumers claim an element by advancing the head with a compare-exchange,
+ * so several threads may pop the same queue.
+ */
+template <typename Data, size_t SIZE> class StaticEventQueue {
+public:
+  static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0,
+                "StaticEventQueue size must be a power of two");
+
+  StaticEventQueue() = default;
+
+  /**
+   * @brief Construct with the interface of LibXR::LockFreeQueue
+   * @param length Requested depth, must not exceed SIZE
+   */
+  explicit StaticEventQueue(size_t length) {
+    ASSERT(length <= SIZE);
+    UNUSED(length);
+  }
+
+  LibXR::ErrorCode Push(const Data &data) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= SIZE) {
+      return LibXR::ErrorCode::FULL;
+    }
+    buffer_[tail & MASK] = data;
+    tail_.store(tail + 1, std::memory_order_release);
+    return LibXR::ErrorCode::OK;
+  }
+
+  LibXR::ErrorCode Pop(Data &data) {
+    uint32_t head = head_.load(std::memory_order_acquire);
+    do {
+      if (head == tail_.load(std::memory_order_acquire)) {
+        return LibXR::ErrorCode::EMPTY;
+      }
+      /* A copy taken after another consumer won is discarded by the CAS */
+      data = buffer_[head & MASK];
+    } while (!head_.compare_exchange_weak(head, head + 1,
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_acquire));
+    return LibXR::ErrorCode::OK;
+  }
+
+  LibXR::ErrorCode Peek(Data &data) {
+    uint32_t head = head_.load(std::memory_order_acquire);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return LibXR::ErrorCode::EMPTY;
+    }
+    data = buffer_[head & MASK];
+    return LibXR::ErrorCode::OK;
+  }
+
+  size_t Size() const {
+    /* Head first, a head read after the tail may already have passed it */
+    uint32_t head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+  }
+
+  size_t EmptySize() const { return SIZE - Size(); }
+
+private:
+  constexpr static uint32_t MASK = SIZE - 1;
+
+  std::array<Data, SIZE> buffer_{}; ///< Element storage
+  std::atomic<uint32_t> head_ = 0;  ///< Next element to pop
+  std::atomic<uint32_t> tail_ = 0;  ///< Next slot to push
+};
+
+/**
+ * @brief Fixed pool of reference counted slots
+ * @tparam Data Slot type
+ * @tparam SIZE Slot count, at most 32
+ * @note Acquire() runs in the producer only, Release() in any consumer.
+ * Free slots live in one atomic bitmap, so neither side blocks or touches
+ * the heap.
+ */
+template <typename Data, size_t SIZE> class PayloadPool {
+public:
+  static_assert(SIZE <= 32, "PayloadPool size must not exceed 32");
+
+  constexpr static uint8_t INVALID = 0xFF; ///< No slot
+
+  /**
+   * @brief Take a free slot
+   * @param refs Number of Release() calls that free it again
+   * @return Slot handle, or INVALID if the pool is exhausted
+   */
+  uint8_t Acquire(uint8_t refs) {
+    uint32_t free = free_.load(std::memory_order_acquire);
+    while (free != 0) {
+      uint8_t slot = 0;
+      while ((free & (1UL << slot)) == 0) {
+        slot++;
+      }
+      if (free_.compare_exchange_weak(free, free & ~(1UL << slot),
+                                      std::memory_order_acquire)) {
+        refs_[slot].store(refs, std::memory_order_relaxed);
+        return slot;
+      }
+    }
+    return INVALID;
+  }
+
+  /**
+   * @brief Drop one reference, the last one frees the slot
+   * @param handle Slot handle, INVALID is ignored
+   */
+  void Release(uint8_t handle) {
+    if (handle >= SIZE) {
+      return;
+    }
+    if (refs_[handle].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      free_.fetch_or(1UL << handle, std::memory_order_release);
+    }
+  }
+
+  Data &operator[](uint8_t handle) { return slots_[handle]; }
+
+  const Data *Get(uint8_t handle) const {
+    return handle < SIZE ? &slots_[handle] : nullptr;
+  }
+
+private:
+  std::array<Data, SIZE> slots_{};                   ///< Slot storage
+  std::array<std::atomic<uint8_t>, SIZE> refs_{};    ///< References left
+  std::atomic<uint32_t> free_ = SIZE == 32 ? UINT32_MAX
+                                           : (1UL << SIZE) - 1; ///< Free bits
+};
+
+} // namespace BitsButtonDetail
+
+template <typename Traits = BitsButtonDefaultTraits>
+class BasicBitsButtonXR : public LibXR::Application {
 public:
   constexpr static uint8_t EVENT_ID_TYPE_BITS = 8;
   constexpr static uint8_t EVENT_ID_INDEX_BITS = 8;
@@ -63,17 +361,82 @@ public:
   constexpr static uint32_t EVENT_ID_TYPE_MASK = 0xFFu;
   constexpr static uint32_t EVENT_ID_INDEX_MASK = 0xFFu;
 
-  enum class ButtonEvent : uint8_t {
-    PRESSED = 0,          ///< Button initially pressed
-    LONG_PRESS_START = 1, ///< Long press detected (after threshold)
-    LONG_PRESS_HOLD = 2,  ///< Periodic long press hold
-    RELEASED = 3,         ///< Button released
-    CLICK_FINISH = 4,     ///< Click followed by long press
-  };
+  using ButtonEvent = BitsButtonEvent;
+
+  constexpr static bool HAS_COMBINED = Traits::ENABLE_COMBINED;
+  constexpr static bool HAS_SUPPRESSION =
+      HAS_COMBINED && Traits::ENABLE_SUPPRESSION;
+  constexpr static bool HAS_CLICK_HISTORY = Traits::ENABLE_CLICK_HISTORY;
+  constexpr static bool HAS_LONG_PRESS =
+      (Traits::EVENT_MASK &
+       (BitsButtonEventBit(ButtonEvent::LONG_PRESS_START) |
+        BitsButtonEventBit(ButtonEvent::LONG_PRESS_HOLD))) != 0;
+  constexpr static bool HAS_CLICK_WINDOW =
+      (Traits::EVENT_MASK & BitsButtonEventBit(ButtonEvent::CLICK_FINISH)) != 0;
+  constexpr static bool HAS_VELOCITY = Traits::MAX_VELOCITY_KEYS > 0;
+  constexpr static bool HAS_WAKE_STATS = Traits::ENABLE_WAKE_STATS;
+  constexpr static bool HAS_STORM_GUARD = Traits::STORM_EDGE_LIMIT > 0;
+  constexpr static bool HAS_TICKLESS_IDLE = Traits::ENABLE_TICKLESS_IDLE;
+  constexpr static bool HAS_SWITCH =
+      (Traits::EVENT_MASK & (BitsButtonEventBit(ButtonEvent::SWITCH_ON) |
+                             BitsButtonEventBit(ButtonEvent::SWITCH_OFF))) != 0;
+  constexpr static bool HAS_SUBSCRIBERS = Traits::MAX_EVENT_SUBSCRIBERS > 0;
+  constexpr static bool HAS_STATIC_QUEUE = Traits::STATIC_EVENT_QUEUE_SIZE > 0;
+  constexpr static bool HAS_LAYERS = Traits::MAX_LAYERS > 0;
+  constexpr static bool HAS_OVERLOAD_GUARD = Traits::OVERLOAD_BUDGET_US > 0;
+  constexpr static bool HAS_TRACE = Traits::Tracer::ENABLED;
+  constexpr static bool HAS_ADAPTIVE_SLEEP = Traits::SLEEP_WAKE_COST_TICKS > 0;
+  constexpr static bool HAS_PAYLOAD = Traits::PAYLOAD_POOL_SIZE > 0;
+  constexpr static bool HAS_HISTORY = Traits::EVENT_HISTORY_SIZE > 0;
+  constexpr static bool HAS_PRESSURE_LEVELS = Traits::ENABLE_PRESSURE_LEVELS;
+  constexpr static bool HAS_SAMPLE_TIMESTAMPS =
+      Traits::ENABLE_SAMPLE_TIMESTAMPS;
+  constexpr static bool HAS_QUEUE_STATS = Traits::ENABLE_QUEUE_STATS;
+  /// GPIO callbacks report their line, needed only to attribute the edge
+  constexpr static bool HAS_ISR_CONTEXT =
+      HAS_WAKE_STATS || HAS_STORM_GUARD || HAS_TRACE;
+  constexpr static uint8_t EVENT_TYPE_COUNT =
+      static_cast<uint8_t>(ButtonEvent::LINE_FAULT) + 1;
+
+  /**
+   * @brief Check whether an event type is compiled in
+   * @param type Event type
+   * @return True if the event can be emitted by this instantiation
+   */
+  constexpr static bool IsEventEnabled(ButtonEvent type) {
+    return (Traits::EVENT_MASK & BitsButtonEventBit(type)) != 0;
+  }
 
   using ButtonStateBits = uint32_t; ///< Bit field for click history tracking
   using ButtonMaskType = uint32_t; ///< Bit mask for button state representation
   using ButtonIndexType = uint8_t; ///< Type for button index values
+  using ButtonIndexMask =
+      uint64_t; ///< Bit mask over logic indices, combined buttons included
+  using SubscriberId = uint8_t; ///< Handle of a filtered consumer queue
+  using PayloadHandle = uint8_t; ///< Slot of an extended event payload
+  using Tracer = typename Traits::Tracer; ///< Timeline trace sink type
+
+  constexpr static uint32_t DEADLINE_NEVER =
+      UINT32_MAX; ///< NextDeadline() value when only edges can wake
+  constexpr static uint16_t TICK_INTERVAL_MS =
+      10; ///< Engine step period while inputs are active
+  constexpr static SubscriberId INVALID_SUBSCRIBER =
+      0xFF; ///< CreateEventQueue() result when no slot is left
+  constexpr static PayloadHandle INVALID_PAYLOAD =
+      0xFF; ///< ButtonEventResult::payload of events without one
+
+  enum class InputType : uint8_t {
+    MOMENTARY = 0, ///< Push button, full click/long press state machine
+    SWITCH = 1, ///< Latching/slide switch, debounced SWITCH_ON/SWITCH_OFF only
+  };
+
+  enum class InputSource : uint8_t {
+    GPIO = 0,     ///< LibXR::GPIO found by key_alias, edge interrupt wakeup
+    EXTERNAL = 1, ///< Level supplied by UpdateExternalInputs (touch, ...)
+    GPIO_POLLED = 2, ///< LibXR::GPIO without edge interrupt, scanned at
+                     ///< IDLE_SCAN_INTERVAL_MS while idle
+    LAYER = 3,       ///< Logical key, driven only by a LayerConfig remap
+  };
 
   struct ButtonConstraints {
     uint16_t short_press_time_ms;         ///< Time threshold for short press
@@ -88,12 +451,42 @@ public:
     std::initializer_list<const char *>
         constituent_aliases;       ///< List of button aliases in combination
     ButtonConstraints constraints; ///< Timing constraints for this combination
+    std::initializer_list<const char *> excluded_aliases =
+        {}; ///< Buttons that must be released for the combination to match
   };
 
   struct SingleButtonConfig {
     const char *key_alias;         ///< GPIO name identifier for the button
     bool active_level;             ///< GPIO level that indicates button press
     ButtonConstraints constraints; ///< Timing constraints for this button
+    InputType input_type =
+        InputType::MOMENTARY; ///< Switches ignore constraints and
+                              ///< never keep the module awake
+    InputSource input_source =
+        InputSource::GPIO; ///< Where the raw level comes from
+    const char *velocity_contact_alias =
+        nullptr; ///< Early contact GPIO, makes key_alias the main contact of
+                 ///< a dual-contact velocity key
+  };
+
+  struct LayerKeyMap {
+    const char *physical_alias; ///< Key pressed while the layer is active
+    const char *logical_alias;  ///< InputSource::LAYER key it produces
+  };
+
+  struct LayerConfig {
+    const char *activation_alias; ///< Key (or switch) holding the layer active
+    std::initializer_list<LayerKeyMap> keys; ///< Remapped keys of this layer
+  };
+
+  /**
+   * @brief Mapping from contact delta to strike velocity
+   * @note Linear interpolation between points, clamped at both ends
+   */
+  struct VelocityCurve {
+    constexpr static size_t POINTS = 8;
+    std::array<uint32_t, POINTS> delta_us; ///< Ascending contact deltas
+    std::array<uint8_t, POINTS> velocity;  ///< Velocity at each delta
   };
 
   struct ButtonEventResult {
@@ -102,22 +495,116 @@ public:
     ButtonStateBits state_bits; ///< Current state bits of all buttons
     uint16_t long_press_count;  ///< Count of long press periods triggered
     uint32_t system_tick;       ///< System tick when event was generated
+    uint8_t velocity; ///< Strike velocity on PRESSED of dual-contact keys,
+                      ///< 0 otherwise
+    ButtonIndexType logic_index; ///< Button index, as used by MakeEventId
+    PayloadHandle payload; ///< Extended data for GetEventPayload, or
+                           ///< INVALID_PAYLOAD
+    uint8_t pressure_level; ///< Analog level on PRESSED/LONG_PRESS_HOLD of
+                            ///< EXTERNAL keys with levels, 0 otherwise
+  };
+
+  /**
+   * @brief Compact copy of an emitted event, kept in the history ring
+   */
+  struct EventRecord {
+    uint32_t system_tick;         ///< System tick when event was generated
+    ButtonIndexType logic_index;  ///< Button index, as used by MakeEventId
+    ButtonEvent event_type;       ///< Type of event that occurred
+    uint16_t long_press_count;    ///< Count of long press periods triggered
+  };
+
+  /**
+   * @brief Extended data of an event, held in the payload pool
+   */
+  struct EventPayload {
+    uint32_t press_tick; ///< Tick of the press that began the sequence
+    uint32_t held_ms;    ///< Time held so far, the whole press on RELEASED
+    uint32_t contact_delta_us;  ///< Early to main contact time of a
+                                ///< dual-contact PRESSED, 0 otherwise
+    ButtonMaskType active_mask; ///< Debounced levels of all single buttons
+  };
+
+  using EventQueue = std::conditional_t<
+      HAS_STATIC_QUEUE,
+      BitsButtonDetail::StaticEventQueue<ButtonEventResult,
+                                         Traits::STATIC_EVENT_QUEUE_SIZE>,
+      LibXR::LockFreeQueue<ButtonEventResult>>; ///< Result queue type
+
+  /**
+   * @brief One interrupt wakeup up to the following sleep
+   */
+  struct WakeEpisode {
+    ButtonIndexType wake_source; ///< Button that woke the module, or
+                                 ///< BITS_BTN_INVALID_INDEX if unknown
+    ButtonIndexType keep_alive_button; ///< Button active for the most ticks,
+                                       ///< or BITS_BTN_INVALID_INDEX
+    uint32_t polled_ticks;             ///< Timer ticks run while awake
+    uint32_t awake_ms;                 ///< Time from first tick to sleep
+  };
+
+  /**
+   * @brief Aggregate wake counters since construction or reset
+   */
+  struct WakeStatistics {
+    uint32_t wake_count;       ///< Completed wake episodes
+    uint32_t polled_ticks;     ///< Timer ticks over all episodes
+    uint32_t awake_ms;         ///< Awake time over all episodes
+    uint32_t hysteresis_ticks; ///< Ticks with no button active
+    uint32_t idle_scan_ticks;  ///< Low-rate scans while asleep
+    WakeEpisode last_episode;  ///< Most recent completed episode
+    std::array<uint32_t, BITS_BTN_MAX_SINGLES>
+        wakes_by_button; ///< Wakeups triggered per single button
+    std::array<uint32_t, BITS_BTN_MAX_TOTAL>
+        keep_alive_ticks; ///< Awake ticks attributed per button
+  };
+
+  /**
+   * @brief Delivery counters of one event queue
+   */
+  struct QueueStatistics {
+    uint32_t pushed;  ///< Events accepted by the queue
+    uint32_t dropped; ///< Events lost because the queue was full
+  };
+
+  /**
+   * @brief Tick load counters since construction or reset
+   */
+  struct OverloadStatistics {
+    uint32_t overrun_ticks;  ///< Ticks longer than OVERLOAD_BUDGET_US
+    uint32_t late_ticks;     ///< Ticks run a whole period after they were due
+    uint32_t overload_count; ///< Times the degraded mode was entered
+    uint32_t shed_events;    ///< Events dropped while degraded
+    uint32_t max_tick_us;    ///< Longest tick measured
   };
 
   /**
-   * @brief Construct a new BitsButtonXR object
+   * @brief Construct a new BasicBitsButtonXR object
    * @param hw Hardware container for GPIO access
    * @param app Application manager reference
    * @param single_configs List of individual button configurations
    * @param combined_configs List of combined button configurations
+   * @param layer_configs List of key layers, earlier layers take precedence
    */
-  BitsButtonXR(LibXR::HardwareContainer &hw, LibXR::ApplicationManager &app,
-               std::initializer_list<SingleButtonConfig> single_configs,
-               std::initializer_list<CombinedButtonConfig> combined_configs)
-      : LibXR::Application(), result_queue_(16),
+  BasicBitsButtonXR(
+      LibXR::HardwareContainer &hw, LibXR::ApplicationManager &app,
+      std::initializer_list<SingleButtonConfig> single_configs,
+      std::initializer_list<CombinedButtonConfig> combined_configs,
+      std::initializer_list<LayerConfig> layer_configs = {})
+      : LibXR::Application(), result_queue_(EVENT_QUEUE_LENGTH),
         state_timer_(LibXR::Timer::CreateTask(StateTimerOnTick, this,
                                               TIMER_INTERVAL_MS)) {
     UNUSED(app);
+    if constexpr (HAS_VELOCITY) {
+      velocity_curve_[0] = {
+          {1000, 2000, 4000, 8000, 16000, 32000, 64000, 128000},
+          {127, 110, 92, 74, 56, 38, 20, 1}};
+    }
+    ResetWakeStatistics();
+    if constexpr (HAS_WAKE_STATS) {
+      wake_accounting_[0].episode = {BITS_BTN_INVALID_INDEX,
+                                     BITS_BTN_INVALID_INDEX, 0, 0};
+    }
     LibXR::Timer::Add(state_timer_);
     LibXR::Timer::Stop(state_timer_);
 
@@ -127,30 +614,55 @@ public:
       ASSERT(result == LibXR::ErrorCode::OK);
     }
 
-    /* Initialize Combined Buttons */
-    for (const auto &cfg : combined_configs) {
-      auto result = InitCombinedButton(cfg);
-      ASSERT(result == LibXR::ErrorCode::OK);
+    if constexpr (!HAS_LAYERS) {
+      /* Layers are compiled out */
+      ASSERT(layer_configs.size() == 0);
+      UNUSED(layer_configs);
+    } else {
+      for (const auto &cfg : layer_configs) {
+        auto result = InitLayer(cfg);
+        ASSERT(result == LibXR::ErrorCode::OK);
+      }
     }
 
-    /* Sort Priorities */
-    SortCombinedButtons();
-
-    /* Mark suppressible physical buttons*/
-    ButtonMaskType global_suppression_mask = 0;
-    for (size_t i = physical_count_; i < total_count_; ++i) {
-      auto &comb = all_buttons_[i];
-      if (comb.cfg.comb.suppress_single) {
-        global_suppression_mask |= comb.cfg.comb.mask;
+    if constexpr (!HAS_COMBINED) {
+      /* Combined buttons are compiled out */
+      ASSERT(combined_configs.size() == 0);
+      UNUSED(combined_configs);
+    } else {
+      /* Initialize Combined Buttons */
+      for (const auto &cfg : combined_configs) {
+        auto result = InitCombinedButton(cfg);
+        ASSERT(result == LibXR::ErrorCode::OK);
       }
+
+      /* Sort Priorities */
+      SortCombinedButtons();
+    }
+
+    /* Inputs without edge interrupts are watched by the idle scan */
+    if (polled_input_mask_ != 0) {
+      last_tick_ = LibXR::Thread::GetTime();
+      StartIdleScan(last_tick_);
     }
 
-    for (size_t p = 0; p < physical_count_; ++p) {
-      auto &phys_btn = all_buttons_[p];
-      ButtonMaskType btn_mask = static_cast<ButtonMaskType>(1UL)
-                                << phys_btn.logic_index;
-      phys_btn.cfg.phys.is_suppressible =
-          (global_suppression_mask & btn_mask) != 0;
+    if constexpr (HAS_SUPPRESSION) {
+      /* Mark suppressible physical buttons*/
+      ButtonMaskType global_suppression_mask = 0;
+      for (size_t i = physical_count_; i < total_count_; ++i) {
+        auto &comb = all_buttons_[i];
+        if (comb.cfg.comb.suppress_single) {
+          global_suppression_mask |= comb.cfg.comb.mask;
+        }
+      }
+
+      for (size_t p = 0; p < physical_count_; ++p) {
+        auto &phys_btn = all_buttons_[p];
+        ButtonMaskType btn_mask = static_cast<ButtonMaskType>(1UL)
+                                  << phys_btn.logic_index;
+        phys_btn.cfg.phys.is_suppressible =
+            (global_suppression_mask & btn_mask) != 0;
+      }
     }
   }
 
@@ -180,297 +692,2146 @@ public:
   }
 
   /**
-   * @brief Get event result and remove from queue
-   * @param out_result Reference to store the event result
-   * @return True if event was successfully retrieved and removed, false
-   * otherwise
+   * @brief Look up the logic index of a single button
+   * @param alias Button alias
+   * @return Logic index (bit position in input masks), or
+   * BITS_BTN_INVALID_INDEX if not found
    */
-  bool GetEventResult(ButtonEventResult &out_result) {
-    return result_queue_.Pop(out_result) == LibXR::ErrorCode::OK;
+  ButtonIndexType FindButtonIndex(const char *alias) {
+    return ResolveAliasToIndex(alias);
   }
 
   /**
-   * @brief Peek event result without removing from queue
-   * @param out_result Reference to store the event result
-   * @return True if event was successfully retrieved, false otherwise
-   * @note Event remains in queue for other callbacks to see. Typically,
-   * event-driven models use "consume" pattern, so GetEventResult is more common
+   * @brief Look up the logic index of a single or combined button
+   * @param alias Button or combination alias
+   * @return Logic index (as in MakeEventId and ButtonEventResult), or
+   * BITS_BTN_INVALID_INDEX if not found
    */
-  bool PeekEventResult(ButtonEventResult &out_result) {
-    return result_queue_.Peek(out_result) == LibXR::ErrorCode::OK;
+  ButtonIndexType FindLogicIndex(const char *alias) const {
+    for (size_t i = 0; alias && i < total_count_; ++i) {
+      if (all_buttons_[i].key_alias &&
+          strcmp(all_buttons_[i].key_alias, alias) == 0) {
+        return all_buttons_[i].logic_index;
+      }
+    }
+    return BITS_BTN_INVALID_INDEX;
   }
 
   /**
-   * @brief Monitor function called by application framework
+   * @brief Update the raw level of EXTERNAL inputs
+   * @param active_mask Active bits as produced by the source
+   * @param source_mask Bits owned by the calling source, other bits are kept
+   * @note Safe from any thread or ISR. Wakes the module when an owned level
+   * changes, the same way a GPIO edge does. The levels then go through the
+   * regular debounce, combined and event pipeline.
    */
-  void OnMonitor() override {}
-
-private:
-  static_assert(BITS_BTN_MAX_SINGLES <= sizeof(ButtonMaskType) * 8,
-                "ButtonMaskType unable to hold all physical buttons");
-  static_assert(BITS_BTN_MAX_TOTAL > 0,
-                "Total button capacity must be positive");
-  static_assert(BITS_BTN_MAX_SINGLES >= 1,
-                "Must support at least one single button");
-  static_assert(BITS_BTN_MAX_COMBINED >= 1,
-                "Must support at least one combined button");
+  void UpdateExternalInputs(ButtonMaskType active_mask,
+                            ButtonMaskType source_mask) {
+    source_mask &= external_input_mask_;
+
+    ButtonMaskType old_mask =
+        external_active_mask_.load(std::memory_order_relaxed);
+    ButtonMaskType new_mask = 0;
+    do {
+      new_mask = (old_mask & ~source_mask) | (active_mask & source_mask);
+    } while (!external_active_mask_.compare_exchange_weak(
+        old_mask, new_mask, std::memory_order_acq_rel,
+        std::memory_order_relaxed));
+
+    if (new_mask != old_mask) {
+      /* Prefer a wake key, a parked module ignores the other inputs */
+      ButtonMaskType changed = new_mask ^ old_mask;
+      ButtonMaskType wake_changed = changed & wake_mask_;
+      WakeUpFromIsr(LowestBitIndex(wake_changed != 0 ? wake_changed : changed));
+    }
+  }
 
-  constexpr static uint16_t TIMER_INTERVAL_MS = 10;
-  constexpr static uint32_t IDLE_SLEEP_THRESHOLD = 10;
-  constexpr static uint8_t DEBOUNCE_THRESHOLD =
-      2; ///< Required stable readings to confirm button state
-  constexpr static uint16_t COMBINED_COMMIT_DELAY_MS =
-      50; ///< Delay for combined button synchronization
+  /**
+   * @brief Update the pressure level of an EXTERNAL input
+   * @param index Logic index from FindButtonIndex
+   * @param level Quantized level, reported by the next PRESSED or
+   * LONG_PRESS_HOLD event of the button
+   * @note Safe from any thread or ISR. Ignored unless ENABLE_PRESSURE_LEVELS
+   * is set.
+   */
+  void UpdateExternalLevel(ButtonIndexType index, uint8_t level) {
+    if constexpr (HAS_PRESSURE_LEVELS) {
+      ASSERT(index < BITS_BTN_MAX_SINGLES);
+      external_levels_[index].store(level, std::memory_order_relaxed);
+    } else {
+      UNUSED(index);
+      UNUSED(level);
+    }
+  }
 
-  enum class InternalState : uint8_t {
-    IDLE = 0,
-    PRESSED = 1,
-    LONG_PRESS = 2,
-    RELEASE = 3,
-    RELEASE_WINDOW = 4,
-    FINISH = 5
-  };
+  /**
+   * @brief Earliest tick at which the module needs the CPU again
+   * @return Tick in ms (LibXR::Thread::GetTime() base), or DEADLINE_NEVER
+   * when only an input edge can change state. A tick already in the past
+   * means processing is due now.
+   * @note Refreshed at the end of every tick. Edge interrupts of GPIO
+   * inputs are masked while awake, so with such inputs the deadline stays
+   * at the next tick until the module sleeps. With ENABLE_TICKLESS_IDLE the
+   * settled inputs are re-armed instead and the deadline may lie beyond the
+   * next tick, so a tickless idle hook may sleep until it. Late ticks are
+   * caught up from elapsed time.
+   */
+  uint32_t NextDeadline() const {
+    return next_deadline_.load(std::memory_order_relaxed);
+  }
 
-  struct GenericButton {
-    const char *key_alias;       ///< Button name identifier
-    InternalState current_state; ///< Current state machine state
-    ButtonStateBits state_bits;  ///< Click history (0b10, 0b1010...)
-    uint32_t state_entry_tick;   ///< Global tick value entering current state
-    uint16_t long_press_cnt;     ///< Long press event triggered count
-    uint8_t debounce_counter; ///< Counter for stable readings (used by physical
-                              ///< buttons)
+  /**
+   * @brief Park the module until a wake key or Resume()
+   * @param wake_mask Inputs that can still wake the module, bit i is
+   * physical button i; GPIO interrupt and EXTERNAL inputs only
+   * @return OK, ARG_ERR if wake_mask names another input, STATE_ERR if the
+   * module is already suspended
+   * @note Safe from any thread and from event callbacks, parking happens on
+   * the next timer tick. Presses in progress end with RELEASED and pending
+   * click sequences are dropped. Then every edge interrupt except those of
+   * the wake keys is disabled and the timer stops. A wake key edge resumes
+   * the module like Resume(). ProcessInputs() users stop calling it
+   * instead.
+   */
+  LibXR::ErrorCode Suspend(ButtonMaskType wake_mask) {
+    if ((wake_mask & ~(interrupt_mask_ | external_input_mask_)) != 0) {
+      return LibXR::ErrorCode::ARG_ERR;
+    }
 
-    enum Type : uint8_t {
-      PHYSICAL,
-      COMBINED
-    } type;              ///< Button type classification
-    uint8_t logic_index; ///< Global index (0 ~ Total-1)
+    /* Claim first so a rejected call leaves the armed mask alone */
+    PowerState expected = PowerState::AWAKE;
+    if (!power_state_.compare_exchange_strong(expected, PowerState::SUSPENDING,
+                                              std::memory_order_acq_rel)) {
+      return LibXR::ErrorCode::STATE_ERR;
+    }
+    wake_mask_ = wake_mask;
+    expected = PowerState::SUSPENDING;
+    if (!power_state_.compare_exchange_strong(expected,
+                                              PowerState::PARK_PENDING,
+                                              std::memory_order_acq_rel)) {
+      return LibXR::ErrorCode::OK; // Resume() won, already on its way back
+    }
+    LibXR::Timer::Start(state_timer_);
+    return LibXR::ErrorCode::OK;
+  }
 
-    union Config {
-      struct {
-        LibXR::GPIO *gpio;           ///< Hardware handle
-        bool active_level;           ///< Active level for button press
-        bool last_raw_state;         ///< Last raw GPIO reading
-        bool debounced_state;        ///< Current debounced stable state
-        bool is_suppressible;        ///< Whether this button participates in a
-                                     ///< suppressible combined
-        uint32_t pending_press_tick; ///< Timestamp when button started waiting
-                                     ///< for combined
-      } phys;
+  /**
+   * @brief Leave the suspended state
+   * @return OK, or STATE_ERR if the module is not suspended
+   * @note Safe from any thread. The next tick re-reads all inputs in one
+   * batch and takes them as debounced, so keys held at that moment report
+   * PRESSED and switches moved while parked report their new state.
+   */
+  LibXR::ErrorCode Resume() {
+    PowerState state = power_state_.load(std::memory_order_acquire);
+    do {
+      if (state == PowerState::AWAKE) {
+        return LibXR::ErrorCode::STATE_ERR;
+      }
+      if (state == PowerState::RESUME_PENDING) {
+        return LibXR::ErrorCode::OK;
+      }
+    } while (!power_state_.compare_exchange_weak(
+        state, PowerState::RESUME_PENDING, std::memory_order_acq_rel,
+        std::memory_order_acquire));
+    LibXR::Timer::Start(state_timer_);
+    return LibXR::ErrorCode::OK;
+  }
 
-      struct {
-        ButtonMaskType mask;  ///< Bit mask of buttons in this combined
-        bool suppress_single; ///< Suppress individual button events
-        uint8_t key_count;    ///< Number of buttons in this combined
-      } comb;
-    } cfg;
+  /**
+   * @brief Check whether the module is suspended or about to be
+   */
+  bool IsSuspended() const {
+    return power_state_.load(std::memory_order_relaxed) != PowerState::AWAKE;
+  }
 
-    ButtonConstraints
-        constraints; ///< Common constraints (shared by both types)
-  };
+  /**
+   * @brief Allow deadlines to be postponed so adjacent ones share a wakeup
+   * @param slack_ms Maximum delay added to the earliest deadline
+   */
+  void SetTimerSlack(uint16_t slack_ms) { timer_slack_ms_ = slack_ms; }
 
-  LibXR::Event button_events_; ///< Event system for button notifications
-  LibXR::LockFreeQueue<ButtonEventResult>
-      result_queue_; ///< Queue for event results
-  LibXR::Timer::TimerHandle
-      state_timer_; ///< Global timer handle for state timing management
-  std::atomic<bool> is_polling_active_ =
-      false; ///< Flag for active polling mode
-  std::atomic<bool> interrupts_need_disable_ =
-      false; ///< Flag to disable interrupts in first timer callback
-  uint32_t idle_hysteresis_ =
-      0;                       ///< Counter to delay sleep after button release
-  uint8_t total_count_ = 0;    ///< Total count of all buttons
-  uint8_t physical_count_ = 0; ///< Count of physical buttons (for optimization)
-  ButtonMaskType current_mask_ = 0; ///< Current button state mask
-  std::array<GenericButton, BITS_BTN_MAX_TOTAL>
-      all_buttons_{}; ///< Unified array of all button states
+  /**
+   * @brief Replace the delta to velocity curve of dual-contact keys
+   * @param curve New curve
+   */
+  void SetVelocityCurve(const VelocityCurve &curve) {
+    if constexpr (HAS_VELOCITY) {
+      velocity_curve_[0] = curve;
+    } else {
+      ASSERT(HAS_VELOCITY);
+      UNUSED(curve);
+    }
+  }
 
-  void RecordHistory(GenericButton &btn, bool pressed) {
-    btn.state_bits = (btn.state_bits << 1) | (pressed ? 1 : 0);
+  /**
+   * @brief Copy the wake and energy accounting counters
+   * @param out_stats Destination of the snapshot
+   * @note Written by the polling timer; a copy taken while awake may mix
+   * values of two consecutive ticks.
+   */
+  void GetWakeStatistics(WakeStatistics &out_stats) const {
+    ASSERT(HAS_WAKE_STATS);
+    if constexpr (HAS_WAKE_STATS) {
+      out_stats = wake_accounting_[0].stats;
+    } else {
+      out_stats = {};
+    }
   }
 
   /**
-   * @brief Reset button state to initial values
-   * @param btn Reference to button to reset
+   * @brief Clear the aggregate wake counters
    */
-  void ResetState(GenericButton &btn) {
-    btn.current_state = InternalState::IDLE;
-    btn.state_bits = 0;
-    btn.state_entry_tick = 0;
-    btn.long_press_cnt = 0;
-    btn.debounce_counter = 0;
-    if (btn.type == GenericButton::PHYSICAL) {
-      btn.cfg.phys.is_suppressible = false;
-      btn.cfg.phys.pending_press_tick = 0;
+  void ResetWakeStatistics() {
+    if constexpr (HAS_WAKE_STATS) {
+      auto &stats = wake_accounting_[0].stats;
+      stats = {};
+      stats.last_episode = {BITS_BTN_INVALID_INDEX, BITS_BTN_INVALID_INDEX, 0,
+                            0};
     }
   }
 
   /**
-   * @brief Initialize a single physical button
-   * @param hw Hardware container for GPIO access
-   * @param cfg Single button configuration
-   * @return Error code indicating success or failure
+   * @brief Idle ticks the module currently waits before sleeping
+   * @return Learned hysteresis with adaptive sleep, the fixed one otherwise
    */
-  LibXR::ErrorCode InitPhysicalButton(LibXR::HardwareContainer &hw,
-                                      const SingleButtonConfig &cfg) {
-    auto &btn = all_buttons_[total_count_];
+  uint16_t GetSleepHysteresis() const { return sleep_threshold_; }
 
-    /* Initialize common parts */
-    btn.type = GenericButton::PHYSICAL;
-    btn.key_alias = cfg.key_alias;
-    btn.logic_index = total_count_;
-    btn.constraints = cfg.constraints;
-    ResetState(btn);
+  /**
+   * @brief Copy the delivery counters of the shared result queue
+   * @param out_stats Destination of the snapshot
+   * @note Written by the producer only and safe to read from any thread;
+   * dropped / (pushed + dropped) is the queue full rate of the consumers
+   * draining it.
+   */
+  void GetQueueStatistics(QueueStatistics &out_stats) const {
+    ReadQueueStatistics(0, out_stats);
+  }
 
-    /* Hardware Lookup */
-    LibXR::GPIO *gpio_handle = hw.template Find<LibXR::GPIO>(cfg.key_alias);
-    if (!gpio_handle) {
-      return LibXR::ErrorCode::NOT_FOUND;
+  /**
+   * @brief Copy the delivery counters of a consumer queue
+   * @param id Subscriber id from CreateEventQueue
+   * @param out_stats Destination of the snapshot
+   */
+  void GetQueueStatistics(SubscriberId id, QueueStatistics &out_stats) const {
+    ASSERT(id < subscriber_count_);
+    ReadQueueStatistics(id + 1, out_stats);
+  }
+
+  /**
+   * @brief Check whether the module currently sheds load
+   * @return True between an overrun or late tick and OVERLOAD_RECOVER_TICKS
+   * healthy ticks in a row
+   */
+  bool IsOverloaded() const { return overloaded_; }
+
+  /**
+   * @brief Copy the tick load counters
+   * @param out_stats Destination of the snapshot
+   */
+  void GetOverloadStatistics(OverloadStatistics &out_stats) const {
+    ASSERT(HAS_OVERLOAD_GUARD);
+    if constexpr (HAS_OVERLOAD_GUARD) {
+      out_stats = overload_stats_[0];
+    } else {
+      out_stats = {};
     }
+  }
 
-    /* Union setup */
-    btn.cfg.phys.gpio = gpio_handle;
-    btn.cfg.phys.active_level = cfg.active_level;
-    btn.cfg.phys.last_raw_state = false;
-    btn.cfg.phys.debounced_state = false;
+  /**
+   * @brief Clear the tick load counters
+   */
+  void ResetOverloadStatistics() {
+    if constexpr (HAS_OVERLOAD_GUARD) {
+      overload_stats_[0] = {};
+    }
+  }
+
+  /**
+   * @brief Attach the sink that receives trace points
+   * @param tracer Sink, or nullptr to stop tracing
+   * @note Only available when Traits::Tracer is enabled.
+   */
+  void SetTracer(Tracer *tracer) {
+    ASSERT(HAS_TRACE);
+    tracer_ = tracer;
+  }
+
+  /**
+   * @brief Get event result and remove from queue
+   * @param out_result Reference to store the event result
+   * @return True if event was successfully retrieved and removed, false
+   * otherwise
+   */
+  bool GetEventResult(ButtonEventResult &out_result) {
+    if constexpr (HAS_PAYLOAD) {
+      shared_queue_read_.store(true, std::memory_order_relaxed);
+    }
+    bool ok = result_queue_.Pop(out_result) == LibXR::ErrorCode::OK;
+    if (ok) {
+      Trace(BitsButtonTracePoint::QUEUE_POP, BITS_BTN_INVALID_INDEX,
+            static_cast<uint32_t>(out_result.event_type));
+    }
+    return ok;
+  }
+
+  /**
+   * @brief Peek event result without removing from queue
+   * @param out_result Reference to store the event result
+   * @return True if event was successfully retrieved, false otherwise
+   * @note Event remains in queue for other callbacks to see. Typically,
+   * event-driven models use "consume" pattern, so GetEventResult is more common
+   */
+  bool PeekEventResult(ButtonEventResult &out_result) {
+    if constexpr (HAS_PAYLOAD) {
+      shared_queue_read_.store(true, std::memory_order_relaxed);
+    }
+    return result_queue_.Peek(out_result) == LibXR::ErrorCode::OK;
+  }
+
+  /**
+   * @brief Create a bounded queue that only receives matching events
+   * @param index_mask Logic indices of interest, bit i is button i
+   * @param type_mask Event types of interest, built with BitsButtonEventBit
+   * @param capacity Queue depth
+   * @return Subscriber id for GetEventResult/PeekEventResult, or
+   * INVALID_SUBSCRIBER when all MAX_EVENT_SUBSCRIBERS slots are taken
+   * @note Call during initialization, before events are produced. Events
+   * are still pushed to the shared queue; a full consumer queue drops only
+   * its own copy. With STATIC_EVENT_QUEUE_SIZE set, the queues are
+   * preallocated in the object and capacity must not exceed that size.
+   */
+  SubscriberId CreateEventQueue(ButtonIndexMask index_mask,
+                                uint32_t type_mask, size_t capacity) {
+    if constexpr (!HAS_SUBSCRIBERS) {
+      UNUSED(index_mask);
+      UNUSED(type_mask);
+      UNUSED(capacity);
+      ASSERT(false);
+      return INVALID_SUBSCRIBER;
+    } else {
+      if (subscriber_count_ >= Traits::MAX_EVENT_SUBSCRIBERS) {
+        return INVALID_SUBSCRIBER;
+      }
+
+      SubscriberId id = subscriber_count_;
+      if constexpr (HAS_STATIC_QUEUE) {
+        ASSERT(capacity <= Traits::STATIC_EVENT_QUEUE_SIZE);
+      } else {
+        subscriber_queues_[id] = new EventQueue(capacity);
+      }
+      subscriber_count_++;
+
+      /* Precompute the fan-out so the producer does no filtering */
+      type_mask &= Traits::EVENT_MASK;
+      for (size_t i = 0; i < MAX_BUTTONS; ++i) {
+        if ((index_mask & (static_cast<ButtonIndexMask>(1) << i)) == 0) {
+          continue;
+        }
+        for (uint8_t t = 0; t < EVENT_TYPE_COUNT; ++t) {
+          if (type_mask & (1UL << t)) {
+            subscriber_map_[i][t] |= static_cast<SubscriberMask>(1U << id);
+          }
+        }
+      }
+      return id;
+    }
+  }
+
+  /**
+   * @brief Get event result from a consumer queue and remove it
+   * @param id Subscriber id from CreateEventQueue
+   * @param out_result Reference to store the event result
+   * @return True if an event was retrieved, false otherwise
+   */
+  bool GetEventResult(SubscriberId id, ButtonEventResult &out_result) {
+    if constexpr (!HAS_SUBSCRIBERS) {
+      UNUSED(id);
+      UNUSED(out_result);
+      return false;
+    } else {
+      ASSERT(id < subscriber_count_);
+      bool ok = SubscriberQueue(id).Pop(out_result) == LibXR::ErrorCode::OK;
+      if (ok) {
+        Trace(BitsButtonTracePoint::QUEUE_POP, BITS_BTN_INVALID_INDEX,
+              static_cast<uint32_t>(out_result.event_type));
+      }
+      return ok;
+    }
+  }
+
+  /**
+   * @brief Peek event result of a consumer queue without removing it
+   * @param id Subscriber id from CreateEventQueue
+   * @param out_result Reference to store the event result
+   * @return True if an event was retrieved, false otherwise
+   */
+  bool PeekEventResult(SubscriberId id, ButtonEventResult &out_result) {
+    if constexpr (!HAS_SUBSCRIBERS) {
+      UNUSED(id);
+      UNUSED(out_result);
+      return false;
+    } else {
+      ASSERT(id < subscriber_count_);
+      return SubscriberQueue(id).Peek(out_result) == LibXR::ErrorCode::OK;
+    }
+  }
+
+  /**
+   * @brief Extended data of a popped event
+   * @param result Event result from any queue
+   * @return Payload, or nullptr if the event carries none
+   * @note Stays valid until ReleaseEventPayload() is called for result.
+   */
+  const EventPayload *GetEventPayload(const ButtonEventResult &result) const {
+    if constexpr (HAS_PAYLOAD) {
+      return payload_pool_.Get(result.payload);
+    } else {
+      UNUSED(result);
+      return nullptr;
+    }
+  }
+
+  /**
+   * @brief Give back the payload reference of a popped event
+   * @param result Event result from any queue, events without payload are
+   * ignored
+   * @note Every queue that accepted the event holds one reference, so each
+   * consumer releases its own copy. Events left unread in a queue keep their
+   * slot in use.
+   */
+  void ReleaseEventPayload(const ButtonEventResult &result) {
+    ReleasePayload(result.payload);
+  }
+
+  /**
+   * @brief Events sent without payload because the pool was exhausted
+   */
+  uint32_t GetPayloadMisses() const { return payload_misses_; }
+
+  /**
+   * @brief Copy the most recent emitted events
+   * @param out Destination, filled oldest first
+   * @param max_count Capacity of out
+   * @param index_mask Logic indices of interest, bit i is button i; filtered
+   * among the last EVENT_HISTORY_SIZE events of all buttons
+   * @return Number of records written
+   * @note Callable from any thread while the module runs. Records are
+   * written by the producer whether or not a queue accepted the event, and
+   * entries overwritten during the copy are left out.
+   */
+  size_t CopyHistory(
+      EventRecord *out, size_t max_count,
+      ButtonIndexMask index_mask = ~static_cast<ButtonIndexMask>(0)) const {
+    if constexpr (!HAS_HISTORY) {
+      UNUSED(out);
+      UNUSED(max_count);
+      UNUSED(index_mask);
+      return 0;
+    } else {
+      constexpr uint32_t SIZE = Traits::EVENT_HISTORY_SIZE;
+      uint32_t end = history_written_.load(std::memory_order_acquire);
+      uint32_t begin = end > SIZE ? end - SIZE : 0;
+
+      /* Newest first, stop at the first slot the producer has reused */
+      size_t count = 0;
+      for (uint32_t i = end; i > begin && count < max_count;) {
+        --i;
+        EventRecord record = history_[i % HISTORY_SLOTS];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (history_written_.load(std::memory_order_relaxed) - i > SIZE) {
+          break;
+        }
+        if (index_mask & (static_cast<ButtonIndexMask>(1)
+                          << record.logic_index)) {
+          out[count++] = record;
+        }
+      }
+
+      for (size_t i = 0; i < count / 2; ++i) {
+        EventRecord tmp = out[i];
+        out[i] = out[count - 1 - i];
+        out[count - 1 - i] = tmp;
+      }
+      return count;
+    }
+  }
+
+  /**
+   * @brief Run one engine step on an externally sampled input mask
+   * @param raw_mask Raw active mask, bit i is physical button i
+   * @param now Tick time in ms, may come from a virtual clock
+   * @note Bypasses GPIO sampling and LibXR::Timer so host simulations and
+   * replay tools can drive the engine deterministically. Must not run
+   * concurrently with the polling timer.
+   */
+  void ProcessInputs(ButtonMaskType raw_mask, uint32_t now) {
+    /* An input edge restarts the sleep hysteresis, as a wakeup does */
+    if ((raw_mask & ~layer_output_mask_) != last_raw_mask_) {
+      idle_hysteresis_ = 0;
+    }
+    ProcessTick(raw_mask, now);
+  }
+
+  /**
+   * @brief Run one engine step on a buffer of consecutive input samples
+   * @param samples Raw active masks in capture order, bit i is physical
+   * button i
+   * @param count Number of samples, at least one
+   * @param now Tick time in ms of the last sample
+   * @param sample_period_us Time between two samples
+   * @note Meant for port captures made by a timer-triggered DMA. Debounce
+   * runs on every sample, bit-parallel over all buttons, and the state
+   * machines run once on the debounced levels at the end of the buffer.
+   * A confirmed press or release is stamped with the time of the first
+   * sample that left the old level, so bounce and buffer latency do not
+   * shift event times. A buffer should span at most TICK_INTERVAL_MS, a
+   * press and release inside one buffer are not seen. Must not run
+   * concurrently with the polling timer or ProcessInputs().
+   */
+  void ProcessSamples(const ButtonMaskType *samples, size_t count,
+                      uint32_t now, uint32_t sample_period_us) {
+    static_assert(DEBOUNCE_THRESHOLD == 2,
+                  "ProcessSamples confirms levels on sample pairs");
+    ASSERT(samples != nullptr && count > 0);
+    if constexpr (!HAS_SAMPLE_TIMESTAMPS) {
+      UNUSED(sample_period_us);
+    }
+
+    uint32_t prev_tick = last_tick_;
+    ButtonMaskType valid = 0;
+    ButtonMaskType previous = 0;
+    ButtonMaskType debounced = 0;
+    for (size_t i = 0; i < physical_count_; ++i) {
+      const auto &btn = all_buttons_[i];
+      ButtonMaskType bit = static_cast<ButtonMaskType>(1UL) << btn.logic_index;
+      valid |= bit;
+      previous |= btn.cfg.phys.last_raw_state ? bit : 0;
+      debounced |= btn.cfg.phys.debounced_state ? bit : 0;
+    }
+    valid &= ~layer_output_mask_;
+
+    ButtonMaskType stamped = 0;
+    ButtonMaskType stable = 0;
+    for (size_t j = 0; j < count; ++j) {
+      ButtonMaskType sample = samples[j] & valid;
+      ButtonMaskType diff = sample ^ debounced;
+
+      /* Rare edge paths: note the first departure, stamp confirmed flips */
+      if constexpr (HAS_SAMPLE_TIMESTAMPS) {
+        if ((diff & ~sample_pending_mask_) != 0) {
+          uint32_t sample_tick =
+              now - static_cast<uint32_t>((count - 1 - j) * sample_period_us /
+                                          1000);
+          for (ButtonMaskType first = diff & ~sample_pending_mask_;
+               first != 0; first &= first - 1) {
+            edge_ticks_[LowestBitIndex(first)] = sample_tick;
+          }
+          sample_pending_mask_ |= diff;
+        }
+      }
+
+      stable = ~(sample ^ previous);
+      ButtonMaskType flip = stable & diff;
+      debounced ^= flip;
+      stamped |= flip;
+      sample_pending_mask_ &= ~stable;
+      previous = sample;
+    }
+
+    /* An input edge restarts the sleep hysteresis, as a wakeup does */
+    if (previous != last_raw_mask_ || stamped != 0) {
+      idle_hysteresis_ = 0;
+    }
+
+    Trace(BitsButtonTracePoint::TICK_BEGIN, BITS_BTN_INVALID_INDEX, previous);
+    last_raw_mask_ = previous;
+    last_tick_ = now;
+
+    for (size_t i = 0; i < physical_count_; ++i) {
+      auto &btn = all_buttons_[i];
+      ButtonMaskType bit = static_cast<ButtonMaskType>(1UL) << btn.logic_index;
+      btn.cfg.phys.last_raw_state = (previous & bit) != 0;
+      btn.cfg.phys.debounced_state = (debounced & bit) != 0;
+      btn.debounce_counter = (stable & bit) != 0 ? DEBOUNCE_THRESHOLD : 1;
+      if (stamped & bit) {
+        Trace(BitsButtonTracePoint::DEBOUNCED, btn.logic_index,
+              btn.cfg.phys.debounced_state);
+      }
+    }
+    current_mask_ = debounced;
+
+    edge_stamp_mask_ = stamped;
+    StepStates(previous == debounced, prev_tick, now);
+    edge_stamp_mask_ = 0;
+  }
+
+  /**
+   * @brief Monitor function called by application framework
+   */
+  void OnMonitor() override {}
+
+private:
+  static_assert(BITS_BTN_MAX_SINGLES <= sizeof(ButtonMaskType) * 8,
+                "ButtonMaskType unable to hold all physical buttons");
+  static_assert(BITS_BTN_MAX_TOTAL > 0,
+                "Total button capacity must be positive");
+  static_assert(BITS_BTN_MAX_SINGLES >= 1,
+                "Must support at least one single button");
+  static_assert(BITS_BTN_MAX_COMBINED >= 1,
+                "Must support at least one combined button");
+  static_assert(BITS_BTN_MAX_TOTAL <= sizeof(ButtonIndexMask) * 8,
+                "ButtonIndexMask unable to hold all buttons");
+  static_assert(Traits::MAX_EVENT_SUBSCRIBERS <= 8,
+                "SubscriberMask unable to hold all subscribers");
+
+  using SubscriberMask = uint8_t; ///< Bit i set: subscriber i wants the event
+
+  constexpr static uint16_t TIMER_INTERVAL_MS = TICK_INTERVAL_MS;
+
+  enum class PowerState : uint8_t {
+    AWAKE = 0,          ///< Regular sleep/wake operation
+    PARK_PENDING = 1,   ///< Suspend() called, the next tick parks
+    PARKED = 2,         ///< Only wake keys armed, timer stopped
+    RESUME_PENDING = 3, ///< Resume() or wake key, the next tick re-syncs
+    SUSPENDING = 4,     ///< Suspend() owns the transition, mask being set
+  };
+  constexpr static size_t HISTORY_SLOTS =
+      HAS_HISTORY ? Traits::EVENT_HISTORY_SIZE + 1 : 0;
+  constexpr static uint32_t IDLE_SLEEP_THRESHOLD = 10;
+  constexpr static uint8_t GAP_WARMUP_SAMPLES =
+      8; ///< Idle gaps observed before the learned hysteresis is used
+  constexpr static uint8_t GAP_DECAY_SAMPLES =
+      128; ///< Histogram is halved at this many samples to follow the user
+  constexpr static uint8_t DEBOUNCE_THRESHOLD =
+      2; ///< Required stable readings to confirm button state
+  constexpr static uint16_t COMBINED_COMMIT_DELAY_MS =
+      50; ///< Delay for combined button synchronization
+  constexpr static size_t MAX_BUTTONS =
+      HAS_COMBINED ? BITS_BTN_MAX_TOTAL
+                   : BITS_BTN_MAX_SINGLES; ///< Storage capacity
+  constexpr static size_t EVENT_QUEUE_LENGTH =
+      HAS_STATIC_QUEUE ? Traits::STATIC_EVENT_QUEUE_SIZE
+                       : 16; ///< Depth of result_queue_
+
+  enum class InternalState : uint8_t {
+    IDLE = 0,
+    PRESSED = 1,
+    LONG_PRESS = 2,
+    RELEASE = 3,
+    RELEASE_WINDOW = 4,
+    FINISH = 5
+  };
+
+  /* Byte fields fill the gap the optional bases leave before key_alias */
+  struct GenericButton
+      : BitsButtonDetail::ClickHistoryField<HAS_CLICK_HISTORY>,
+        BitsButtonDetail::PressTickField<HAS_PAYLOAD>,
+        BitsButtonDetail::LongPressField<HAS_LONG_PRESS> {
+    InternalState current_state; ///< Current state machine state
+    uint8_t debounce_counter; ///< Counter for stable readings (used by physical
+                              ///< buttons)
+    const char *key_alias;     ///< Button name identifier
+    uint32_t state_entry_tick; ///< Global tick value entering current state
+
+    enum Type : uint8_t {
+      PHYSICAL,
+      COMBINED
+    } type;              ///< Button type classification
+    uint8_t logic_index; ///< Global index (0 ~ Total-1)
+
+    union Config {
+      struct PhysicalConfig
+          : BitsButtonDetail::PendingPressField<HAS_SUPPRESSION> {
+        LibXR::GPIO *gpio;    ///< Hardware handle
+        bool active_level;    ///< Active level for button press
+        bool last_raw_state;  ///< Last raw GPIO reading
+        bool debounced_state; ///< Current debounced stable state
+        bool is_switch;       ///< Level-only switch input
+      } phys;
+
+      struct {
+        ButtonMaskType mask;  ///< Bit mask of buttons in this combined
+        ButtonMaskType care_mask; ///< mask plus excluded buttons, matched as
+                                  ///< (current & care_mask) == mask
+        bool suppress_single; ///< Suppress individual button events
+        uint8_t key_count;    ///< Number of buttons in this combined
+      } comb;
+    } cfg;
+
+    ButtonConstraints
+        constraints; ///< Common constraints (shared by both types)
+  };
+
+  /**
+   * @brief ISR-side capture of a dual-contact key
+   * @note The main stamp is dropped whenever the main contact opens, the
+   * early stamp only when the early contact opens while the main one is
+   * open. Contact bounce therefore never leaves a stale stamp behind.
+   */
+  struct VelocityContact {
+    BasicBitsButtonXR *owner;               ///< Module to wake
+    LibXR::GPIO *main_gpio;                 ///< Contact defining the press
+    LibXR::GPIO *early_gpio;                ///< Contact closing first
+    bool active_level;                      ///< Active level of both contacts
+    ButtonIndexType index;                  ///< Logic index of the key
+    std::atomic<bool> main_captured;        ///< main_us holds this stroke
+    std::atomic<bool> early_captured;       ///< early_us holds this stroke
+    std::atomic<uint32_t> main_us;          ///< Main contact close time
+    std::atomic<uint32_t> early_us;         ///< Early contact close time
+  };
+
+  /**
+   * @brief Remap table of one key layer
+   */
+  struct Layer {
+    ButtonMaskType activation_mask; ///< Key holding the layer active
+    ButtonMaskType source_mask;     ///< Physical keys remapped by the layer
+    ButtonMaskType routed_mask;     ///< Keys pressed on this layer, held
+    std::array<ButtonIndexType, BITS_BTN_MAX_SINGLES>
+        target; ///< Logical index per physical index of source_mask
+  };
+
+  /**
+   * @brief Producer side of QueueStatistics
+   */
+  struct QueueCounters {
+    std::atomic<uint32_t> pushed;  ///< Events accepted by the queue
+    std::atomic<uint32_t> dropped; ///< Events lost because the queue was full
+  };
+
+  /**
+   * @brief Wake accounting state, compiled out with ENABLE_WAKE_STATS
+   */
+  struct WakeAccounting {
+    WakeStatistics stats;        ///< Aggregate wake accounting
+    WakeEpisode episode;         ///< Episode being accounted
+    uint32_t episode_start_tick; ///< First tick of episode
+    std::array<uint32_t, MAX_BUTTONS>
+        alive_ticks; ///< Per-button active ticks in this episode
+  };
+
+  /**
+   * @brief Per-line argument of the GPIO wakeup callback, HAS_ISR_CONTEXT
+   */
+  struct IsrContext : BitsButtonDetail::StormGuardField<HAS_STORM_GUARD> {
+    BasicBitsButtonXR *owner; ///< Module to wake
+    ButtonIndexType index;    ///< Logic index of the line
+  };
+
+  LibXR::Event button_events_; ///< Event system for button notifications
+  EventQueue result_queue_; ///< Queue for event results
+  LibXR::Timer::TimerHandle
+      state_timer_; ///< Global timer handle for state timing management
+  std::atomic<bool> is_polling_active_ =
+      false; ///< Flag for active polling mode
+  std::atomic<bool> interrupts_need_disable_ =
+      false; ///< Flag to disable interrupts in first timer callback
+  uint32_t idle_hysteresis_ =
+      0;                       ///< Counter to delay sleep after button release
+  uint8_t total_count_ = 0;    ///< Total count of all buttons
+  uint8_t physical_count_ = 0; ///< Count of physical buttons (for optimization)
+  ButtonMaskType current_mask_ = 0; ///< Current button state mask
+  ButtonMaskType switch_mask_ =
+      0; ///< Switch inputs, excluded from the polling keep-alive
+  ButtonMaskType external_input_mask_ = 0; ///< Inputs without a GPIO
+  std::array<std::atomic<uint8_t>, HAS_PRESSURE_LEVELS ? BITS_BTN_MAX_SINGLES
+                                                      : 0>
+      external_levels_{}; ///< Pressure levels of EXTERNAL inputs
+  std::atomic<ButtonMaskType> external_active_mask_ =
+      0; ///< Latest levels from UpdateExternalInputs
+  ButtonMaskType interrupt_mask_ = 0; ///< GPIO inputs with edge interrupts
+  ButtonMaskType polled_input_mask_ =
+      0; ///< GPIO inputs without edge interrupts
+  ButtonMaskType last_raw_mask_ = 0; ///< Raw mask of the last processed tick
+  uint32_t last_tick_ = 0;           ///< Time of the last processed tick
+  ButtonMaskType sample_pending_mask_ =
+      0; ///< ProcessSamples lines off their debounced level, edge noted
+  ButtonMaskType edge_stamp_mask_ =
+      0; ///< Lines whose state change this step uses edge_ticks_
+  ButtonMaskType stamped_release_mask_ =
+      0; ///< Buttons in RELEASE entered at a sample edge time
+  std::array<uint32_t, HAS_SAMPLE_TIMESTAMPS ? BITS_BTN_MAX_SINGLES : 0>
+      edge_ticks_{}; ///< First edge time of a pending ProcessSamples change
+  bool interrupts_armed_ = true; ///< Edge interrupts of interrupt_mask_ on
+  std::atomic<PowerState> power_state_ =
+      PowerState::AWAKE; ///< Suspend/Resume progress
+  ButtonMaskType wake_mask_ = 0; ///< Inputs that end a suspension
+  uint16_t timer_slack_ms_ = 0;  ///< Deadline coalescing tolerance
+  std::atomic<uint32_t> next_deadline_ =
+      DEADLINE_NEVER; ///< Result of the last deadline update
+  std::atomic<ButtonMaskType> storm_mask_ =
+      0; ///< Lines masked after an interrupt storm
+  std::atomic<ButtonMaskType> fault_pending_mask_ =
+      0; ///< Storms not yet reported as LINE_FAULT
+  std::atomic<ButtonMaskType> storm_edge_mask_ =
+      0; ///< Lines whose edge since the last tick was counted
+  ButtonMaskType velocity_mask_ =
+      0; ///< Dual-contact keys, interrupts stay armed while polling
+  std::array<VelocityContact, Traits::MAX_VELOCITY_KEYS>
+      velocity_contacts_{}; ///< Edge capture of dual-contact keys
+  uint8_t velocity_count_ = 0; ///< Used velocity_contacts_ slots
+  std::array<IsrContext, HAS_ISR_CONTEXT ? BITS_BTN_MAX_SINGLES : 0>
+      isr_contexts_{}; ///< GPIO callback arguments, by logic index
+  std::array<WakeAccounting, HAS_WAKE_STATS ? 1 : 0>
+      wake_accounting_{}; ///< Wake attribution and awake time state
+  std::array<VelocityCurve, HAS_VELOCITY ? 1 : 0>
+      velocity_curve_{}; ///< Contact delta to velocity
+  std::array<std::conditional_t<HAS_STATIC_QUEUE, EventQueue, EventQueue *>,
+             Traits::MAX_EVENT_SUBSCRIBERS>
+      subscriber_queues_{}; ///< Filtered consumer queues
+  uint8_t subscriber_count_ = 0; ///< Used subscriber_queues_ slots
+  std::array<std::array<SubscriberMask, EVENT_TYPE_COUNT>,
+             HAS_SUBSCRIBERS ? MAX_BUTTONS : 0>
+      subscriber_map_{}; ///< Subscribers per (logic index, event type)
+  std::array<QueueCounters,
+             HAS_QUEUE_STATS ? Traits::MAX_EVENT_SUBSCRIBERS + 1 : 0>
+      queue_stats_{}; ///< Shared queue, then one entry per subscriber
+  Tracer *tracer_ = nullptr;            ///< Trace sink, HAS_TRACE only
+  uint16_t sleep_threshold_ =
+      IDLE_SLEEP_THRESHOLD; ///< Idle ticks before sleeping
+  std::array<uint8_t, HAS_ADAPTIVE_SLEEP ? Traits::ADAPTIVE_SLEEP_MAX_TICKS + 1
+                                         : 0>
+      gap_histogram_{}; ///< Idle-to-activity gaps in ticks, last bin is
+                        ///< "longer than any hysteresis"
+  uint8_t gap_samples_ = 0;  ///< Samples in gap_histogram_
+  bool gap_open_ = false;    ///< Idle since idle_since_
+  uint32_t idle_since_ = 0;  ///< First idle tick of the current gap
+  std::array<OverloadStatistics, HAS_OVERLOAD_GUARD ? 1 : 0>
+      overload_stats_{}; ///< Tick load accounting
+  bool overloaded_ = false;             ///< Degraded mode, events shed
+  uint16_t healthy_ticks_ = 0; ///< Ticks within budget since the last overrun
+  std::array<Layer, Traits::MAX_LAYERS> layers_{}; ///< Key layer tables
+  uint8_t layer_count_ = 0; ///< Used layers_ slots
+  ButtonMaskType layer_output_mask_ = 0; ///< InputSource::LAYER keys
+  ButtonMaskType layer_last_mask_ =
+      0; ///< Physical mask of the previous layer pass
+  BitsButtonDetail::PayloadPool<EventPayload, Traits::PAYLOAD_POOL_SIZE>
+      payload_pool_; ///< Extended event payloads
+  uint32_t payload_misses_ = 0; ///< Payloads lost to an exhausted pool
+  std::atomic<bool> shared_queue_read_ =
+      false; ///< result_queue_ has a consumer, its events hold payloads
+  std::array<EventRecord, HISTORY_SLOTS>
+      history_{}; ///< Recent events, one spare slot marks the one in write
+  std::atomic<uint32_t> history_written_ = 0; ///< Records written so far
+  std::array<GenericButton, MAX_BUTTONS>
+      all_buttons_{}; ///< Unified array of all button states
+
+  /**
+   * @brief Free-running microsecond time, wraps every ~71 minutes
+   * @note Differences of two readings stay correct across the wrap.
+   */
+  static uint32_t NowUs() {
+    return static_cast<uint32_t>(
+        static_cast<uint64_t>(LibXR::Timebase::GetMicroseconds()));
+  }
+
+  /**
+   * @brief Hand one trace point to the tracer
+   * @param point Trace point
+   * @param index Logic index, or BITS_BTN_INVALID_INDEX
+   * @param value Point specific value
+   * @note Compiles to nothing unless Traits::Tracer is enabled.
+   */
+  void Trace(BitsButtonTracePoint point, uint8_t index, uint32_t value) {
+    if constexpr (HAS_TRACE) {
+      if (tracer_) {
+        tracer_->Record(point, index, value, NowUs());
+      }
+    } else {
+      UNUSED(point);
+      UNUSED(index);
+      UNUSED(value);
+    }
+  }
+
+  /**
+   * @brief Count the outcome of one push
+   * @param slot queue_stats_ entry, 0 for the shared queue
+   * @param result Result of the push
+   * @note The producer is the only writer, so a relaxed load and store is
+   * enough; readers on other threads never see a torn counter.
+   */
+  void CountPush(size_t slot, LibXR::ErrorCode result) {
+    if constexpr (HAS_QUEUE_STATS) {
+      auto &counter = result == LibXR::ErrorCode::OK
+                          ? queue_stats_[slot].pushed
+                          : queue_stats_[slot].dropped;
+      counter.store(counter.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    } else {
+      UNUSED(slot);
+      UNUSED(result);
+    }
+  }
+
+  void ReadQueueStatistics(size_t slot, QueueStatistics &out_stats) const {
+    ASSERT(HAS_QUEUE_STATS);
+    if constexpr (HAS_QUEUE_STATS) {
+      out_stats.pushed =
+          queue_stats_[slot].pushed.load(std::memory_order_relaxed);
+      out_stats.dropped =
+          queue_stats_[slot].dropped.load(std::memory_order_relaxed);
+    } else {
+      UNUSED(slot);
+      out_stats = {};
+    }
+  }
+
+  /**
+   * @brief Consumer queue of a subscriber, preallocated or on the heap
+   * @param id Subscriber id
+   * @return Queue reference
+   */
+  EventQueue &SubscriberQueue(SubscriberId id) {
+    if constexpr (HAS_STATIC_QUEUE) {
+      return subscriber_queues_[id];
+    } else {
+      return *subscriber_queues_[id];
+    }
+  }
+
+  void RecordHistory(GenericButton &btn, bool pressed) {
+    if constexpr (HAS_CLICK_HISTORY) {
+      btn.state_bits = (btn.state_bits << 1) | (pressed ? 1 : 0);
+    }
+  }
+
+  void ClearHistory(GenericButton &btn) {
+    if constexpr (HAS_CLICK_HISTORY) {
+      btn.state_bits = 0;
+    }
+  }
+
+  void ClearLongPressCount(GenericButton &btn) {
+    if constexpr (HAS_LONG_PRESS) {
+      btn.long_press_cnt = 0;
+    }
+  }
+
+  /**
+   * @brief Reset button state to initial values
+   * @param btn Reference to button to reset
+   */
+  void ResetState(GenericButton &btn) {
+    btn.current_state = InternalState::IDLE;
+    btn.state_entry_tick = 0;
+    btn.debounce_counter = 0;
+    ClearHistory(btn);
+    ClearLongPressCount(btn);
+    if constexpr (HAS_SUPPRESSION) {
+      if (btn.type == GenericButton::PHYSICAL) {
+        btn.cfg.phys.is_suppressible = false;
+        btn.cfg.phys.pending_press_tick = 0;
+      }
+    }
+  }
+
+  /**
+   * @brief Initialize a single physical button
+   * @param hw Hardware container for GPIO access
+   * @param cfg Single button configuration
+   * @return Error code indicating success or failure
+   */
+  LibXR::ErrorCode InitPhysicalButton(LibXR::HardwareContainer &hw,
+                                      const SingleButtonConfig &cfg) {
+    auto &btn = all_buttons_[total_count_];
+
+    /* Initialize common parts */
+    btn.type = GenericButton::PHYSICAL;
+    btn.key_alias = cfg.key_alias;
+    btn.logic_index = total_count_;
+    btn.constraints = cfg.constraints;
+    ResetState(btn);
+
+    ButtonMaskType btn_bit = static_cast<ButtonMaskType>(1UL)
+                             << btn.logic_index;
+    bool is_external = cfg.input_source == InputSource::EXTERNAL;
+    bool is_polled = cfg.input_source == InputSource::GPIO_POLLED;
+    bool is_layer = cfg.input_source == InputSource::LAYER;
+
+    /* Hardware Lookup, external and layer inputs have no GPIO */
+    LibXR::GPIO *gpio_handle = nullptr;
+    if (!is_external && !is_layer) {
+      gpio_handle = hw.template Find<LibXR::GPIO>(cfg.key_alias);
+      if (!gpio_handle) {
+        return LibXR::ErrorCode::NOT_FOUND;
+      }
+    }
+
+    /* Union setup */
+    btn.cfg.phys.gpio = gpio_handle;
+    btn.cfg.phys.active_level = cfg.active_level;
+    btn.cfg.phys.last_raw_state = false;
+    btn.cfg.phys.debounced_state = false;
+    ASSERT(HAS_SWITCH || cfg.input_type != InputType::SWITCH);
+    btn.cfg.phys.is_switch = HAS_SWITCH && cfg.input_type == InputType::SWITCH;
+
+    if (is_external) {
+      /* Level is supplied through UpdateExternalInputs() */
+      external_input_mask_ |= btn_bit;
+    } else if (is_layer) {
+      /* Level is produced by the layer stage in ProcessTick() */
+      ASSERT(HAS_LAYERS && !btn.cfg.phys.is_switch);
+      layer_output_mask_ |= btn_bit;
+    } else if (is_polled) {
+      /* No edge interrupt, changes are found by the idle scan */
+      ASSERT(!cfg.velocity_contact_alias);
+      auto pull =
+          cfg.active_level ? LibXR::GPIO::Pull::DOWN : LibXR::GPIO::Pull::UP;
+      gpio_handle->SetConfig({LibXR::GPIO::Direction::INPUT, pull});
+      polled_input_mask_ |= btn_bit;
+    } else {
+      /* Hardware Config */
+      auto dir = LibXR::GPIO::Direction::FALL_RISING_INTERRUPT;
+      auto pull =
+          cfg.active_level ? LibXR::GPIO::Pull::DOWN : LibXR::GPIO::Pull::UP;
+      gpio_handle->SetConfig({dir, pull});
+
+      if (cfg.velocity_contact_alias) {
+        auto result = InitVelocityContact(hw, btn, cfg);
+        if (result != LibXR::ErrorCode::OK) {
+          return result;
+        }
+      } else if constexpr (HAS_ISR_CONTEXT) {
+        /* Callback Registration */
+        auto &context = isr_contexts_[btn.logic_index];
+        context.owner = this;
+        context.index = btn.logic_index;
+        if constexpr (HAS_STORM_GUARD) {
+          context.backoff_ms = Traits::STORM_BACKOFF_MS;
+        }
+        auto gpio_callback = LibXR::GPIO::Callback::Create(
+            [](bool, IsrContext *line) {
+              if constexpr (HAS_STORM_GUARD) {
+                line->owner->GuardEdgeFromIsr(*line);
+              }
+              line->owner->WakeUpFromIsr(line->index);
+            },
+            &context);
+        gpio_handle->RegisterCallback(gpio_callback);
+      } else {
+        /* Callback Registration, the line is not needed */
+        auto gpio_callback = LibXR::GPIO::Callback::Create(
+            [](bool, BasicBitsButtonXR *instance) {
+              instance->WakeUpFromIsr(BITS_BTN_INVALID_INDEX);
+            },
+            this);
+        gpio_handle->RegisterCallback(gpio_callback);
+      }
+      gpio_handle->EnableInterrupt();
+      interrupt_mask_ |= btn_bit;
+    }
+
+    /* Switches start from their current level without emitting an event */
+    if (btn.cfg.phys.is_switch) {
+      bool is_on =
+          gpio_handle ? gpio_handle->Read() == cfg.active_level
+                      : (external_active_mask_.load() & btn_bit) != 0;
+      btn.cfg.phys.last_raw_state = is_on;
+      btn.cfg.phys.debounced_state = is_on;
+      btn.debounce_counter = DEBOUNCE_THRESHOLD;
+      btn.current_state = is_on ? InternalState::PRESSED : InternalState::IDLE;
+      switch_mask_ |= btn_bit;
+    }
+
+    physical_count_++;
+    total_count_++;
+    return LibXR::ErrorCode::OK;
+  }
+
+  /**
+   * @brief Pair the early contact of a dual-contact key with its main contact
+   * @param hw Hardware container for GPIO access
+   * @param btn Button owning the main contact (already configured)
+   * @param cfg Single button configuration
+   * @return Error code indicating success or failure
+   */
+  LibXR::ErrorCode InitVelocityContact(LibXR::HardwareContainer &hw,
+                                       GenericButton &btn,
+                                       const SingleButtonConfig &cfg) {
+    if (velocity_count_ >= Traits::MAX_VELOCITY_KEYS) {
+      return LibXR::ErrorCode::NO_MEM;
+    }
+
+    LibXR::GPIO *early_gpio =
+        hw.template Find<LibXR::GPIO>(cfg.velocity_contact_alias);
+    if (!early_gpio) {
+      return LibXR::ErrorCode::NOT_FOUND;
+    }
+
+    auto &contact = velocity_contacts_[velocity_count_];
+    contact.owner = this;
+    contact.main_gpio = btn.cfg.phys.gpio;
+    contact.early_gpio = early_gpio;
+    contact.active_level = cfg.active_level;
+    contact.index = btn.logic_index;
+    contact.main_captured = false;
+    contact.early_captured = false;
+
+    auto pull =
+        cfg.active_level ? LibXR::GPIO::Pull::DOWN : LibXR::GPIO::Pull::UP;
+    early_gpio->SetConfig(
+        {LibXR::GPIO::Direction::FALL_RISING_INTERRUPT, pull});
+
+    /* Both contacts timestamp their edges with microsecond resolution */
+    auto main_callback = LibXR::GPIO::Callback::Create(
+        [](bool, VelocityContact *edge_contact) {
+          uint32_t now_us = NowUs();
+          if (edge_contact->main_gpio->Read() == edge_contact->active_level) {
+            if (!edge_contact->main_captured) {
+              edge_contact->main_us = now_us;
+              edge_contact->main_captured = true;
+            }
+          } else {
+            edge_contact->main_captured = false;
+          }
+          edge_contact->owner->WakeUpFromIsr(edge_contact->index);
+        },
+        &contact);
+    auto early_callback = LibXR::GPIO::Callback::Create(
+        [](bool, VelocityContact *edge_contact) {
+          uint32_t now_us = NowUs();
+          if (edge_contact->early_gpio->Read() == edge_contact->active_level) {
+            if (!edge_contact->early_captured) {
+              edge_contact->early_us = now_us;
+              edge_contact->early_captured = true;
+            }
+          } else if (!edge_contact->main_captured) {
+            edge_contact->early_captured = false;
+          }
+        },
+        &contact);
+    btn.cfg.phys.gpio->RegisterCallback(main_callback);
+    early_gpio->RegisterCallback(early_callback);
+    early_gpio->EnableInterrupt();
+
+    velocity_mask_ |= static_cast<ButtonMaskType>(1UL) << btn.logic_index;
+    velocity_count_++;
+    return LibXR::ErrorCode::OK;
+  }
+
+  /**
+   * @brief Build the remap table of a key layer
+   * @param cfg Layer configuration
+   * @return Error code indicating success or failure
+   */
+  LibXR::ErrorCode InitLayer(const LayerConfig &cfg) {
+    if (layer_count_ >= Traits::MAX_LAYERS) {
+      return LibXR::ErrorCode::NO_MEM;
+    }
+
+    uint8_t activation_idx = ResolveAliasToIndex(cfg.activation_alias);
+    if (activation_idx == BITS_BTN_INVALID_INDEX) {
+      return LibXR::ErrorCode::NOT_FOUND;
+    }
+    ButtonMaskType activation_bit = static_cast<ButtonMaskType>(1UL)
+                                    << activation_idx;
+    if (layer_output_mask_ & activation_bit) {
+      return LibXR::ErrorCode::ARG_ERR;
+    }
+
+    auto &layer = layers_[layer_count_];
+    layer.activation_mask = activation_bit;
+    layer.source_mask = 0;
+    layer.routed_mask = 0;
+
+    for (const auto &map : cfg.keys) {
+      uint8_t src_idx = ResolveAliasToIndex(map.physical_alias);
+      uint8_t dst_idx = ResolveAliasToIndex(map.logical_alias);
+      if (src_idx == BITS_BTN_INVALID_INDEX ||
+          dst_idx == BITS_BTN_INVALID_INDEX) {
+        return LibXR::ErrorCode::NOT_FOUND;
+      }
+
+      ButtonMaskType src_bit = static_cast<ButtonMaskType>(1UL) << src_idx;
+      ButtonMaskType dst_bit = static_cast<ButtonMaskType>(1UL) << dst_idx;
+      if (src_idx == activation_idx || (layer_output_mask_ & src_bit) ||
+          (switch_mask_ & src_bit) || !(layer_output_mask_ & dst_bit)) {
+        return LibXR::ErrorCode::ARG_ERR;
+      }
+
+      layer.source_mask |= src_bit;
+      layer.target[src_idx] = dst_idx;
+    }
+
+    layer_count_++;
+    return LibXR::ErrorCode::OK;
+  }
+
+  /**
+   * @brief Route debounced physical keys through the active layers
+   * @param physical_mask Debounced mask of the physical keys
+   * @return Logical mask seen by combined matching and the state machines
+   * @note A key stays on the layer it was pressed on until it is released,
+   * so letting go of the activation key first never leaks a base key press.
+   * Only the few held keys are remapped, one table lookup each.
+   */
+  ButtonMaskType ApplyLayers(ButtonMaskType physical_mask) {
+    ButtonMaskType new_presses = physical_mask & ~layer_last_mask_;
+    layer_last_mask_ = physical_mask;
+
+    ButtonMaskType routed = 0;
+    for (size_t l = 0; l < layer_count_; ++l) {
+      layers_[l].routed_mask &= physical_mask;
+      routed |= layers_[l].routed_mask;
+    }
+
+    /* New presses join the first active layer that maps them */
+    for (size_t l = 0; l < layer_count_; ++l) {
+      auto &layer = layers_[l];
+      if (physical_mask & layer.activation_mask) {
+        ButtonMaskType take = new_presses & layer.source_mask & ~routed;
+        layer.routed_mask |= take;
+        routed |= take;
+      }
+    }
+
+    ButtonMaskType logical_mask = physical_mask & ~routed;
+    for (size_t l = 0; l < layer_count_; ++l) {
+      ButtonMaskType moved = layers_[l].routed_mask;
+      while (moved != 0) {
+        logical_mask |= static_cast<ButtonMaskType>(1UL)
+                        << layers_[l].target[LowestBitIndex(moved)];
+        moved &= moved - 1;
+      }
+    }
+    return logical_mask;
+  }
+
+  /**
+   * @brief Edge capture of a dual-contact key
+   * @param btn Button to look up
+   * @return Capture of the key, or nullptr for a single-contact button
+   */
+  const VelocityContact *FindVelocityContact(const GenericButton &btn) const {
+    if (btn.type != GenericButton::PHYSICAL ||
+        (velocity_mask_ & (static_cast<ButtonMaskType>(1UL)
+                           << btn.logic_index)) == 0) {
+      return nullptr;
+    }
+    for (size_t i = 0; i < velocity_count_; ++i) {
+      if (velocity_contacts_[i].index == btn.logic_index) {
+        return &velocity_contacts_[i];
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Strike velocity of a button at PRESSED time
+   * @param btn Button being pressed
+   * @return Velocity from the contact delta, 0 if not a dual-contact key
+   */
+  uint8_t ReadVelocity(const GenericButton &btn) const {
+    const VelocityContact *slot = FindVelocityContact(btn);
+    if (!slot) {
+      return 0;
+    }
+
+    const auto &contact = *slot;
+    const auto &curve = velocity_curve_[0];
+    if (!contact.early_captured || !contact.main_captured) {
+      /* Early edge lost or main already bouncing open: fastest strike */
+      return curve.velocity[0];
+    }
+
+    uint32_t delta_us = contact.main_us - contact.early_us;
+    if (delta_us <= curve.delta_us[0]) {
+      return curve.velocity[0];
+    }
+    for (size_t i = 1; i < VelocityCurve::POINTS; ++i) {
+      if (delta_us <= curve.delta_us[i]) {
+        int32_t v0 = curve.velocity[i - 1];
+        int32_t v1 = curve.velocity[i];
+        uint32_t span = curve.delta_us[i] - curve.delta_us[i - 1];
+        uint32_t offset = delta_us - curve.delta_us[i - 1];
+        return static_cast<uint8_t>(
+            v0 + (v1 - v0) * static_cast<int32_t>(offset) /
+                     static_cast<int32_t>(span));
+      }
+    }
+    return curve.velocity[VelocityCurve::POINTS - 1];
+  }
+
+  /**
+   * @brief Helper: Resolve a string alias to a logical index
+   * Only searches currently initialized PHYSICAL buttons.
+   */
+  uint8_t ResolveAliasToIndex(const char *alias) {
+    if (!alias) {
+      return BITS_BTN_INVALID_INDEX;
+    }
+
+    for (uint8_t i = 0; i < physical_count_; ++i) {
+      if (all_buttons_[i].type == GenericButton::PHYSICAL &&
+          all_buttons_[i].key_alias &&
+          strcmp(all_buttons_[i].key_alias, alias) == 0) {
+        return all_buttons_[i].logic_index;
+      }
+    }
+    return BITS_BTN_INVALID_INDEX;
+  }
+
+  /**
+   * @brief Initialize a combined button using aliases
+   * @param cfg Combined button configuration
+   * @return ErrorCode indicating success or failure
+   */
+  LibXR::ErrorCode InitCombinedButton(const CombinedButtonConfig &cfg) {
+    /* Calculate Mask by resolving aliases */
+    ButtonMaskType mask = 0;
+    uint8_t valid_key_count = 0;
+
+    for (const char *alias : cfg.constituent_aliases) {
+      uint8_t idx = ResolveAliasToIndex(alias);
+
+      if (idx == BITS_BTN_INVALID_INDEX) {
+        return LibXR::ErrorCode::NOT_FOUND;
+      }
+
+      mask |= static_cast<ButtonMaskType>(1UL) << idx;
+      valid_key_count++;
+    }
+
+    if (valid_key_count == 0) {
+      return LibXR::ErrorCode::ARG_ERR;
+    }
+
+    /* Excluded buttons are cared about but required to be released */
+    ButtonMaskType care_mask = mask;
+    for (const char *alias : cfg.excluded_aliases) {
+      uint8_t idx = ResolveAliasToIndex(alias);
+
+      if (idx == BITS_BTN_INVALID_INDEX) {
+        return LibXR::ErrorCode::NOT_FOUND;
+      }
+
+      ButtonMaskType bit = static_cast<ButtonMaskType>(1UL) << idx;
+      if (mask & bit) {
+        return LibXR::ErrorCode::ARG_ERR;
+      }
+      care_mask |= bit;
+    }
+
+    /* Setup the object */
+    auto &btn = all_buttons_[total_count_];
+
+    btn.type = GenericButton::COMBINED;
+    btn.key_alias = cfg.combined_alias;
+    btn.logic_index = total_count_;
+    btn.constraints = cfg.constraints;
+    ResetState(btn);
+
+    btn.cfg.comb.mask = mask;
+    btn.cfg.comb.care_mask = care_mask;
+    btn.cfg.comb.suppress_single = cfg.suppress_single_keys;
+    btn.cfg.comb.key_count = valid_key_count;
+
+    total_count_++;
+    return LibXR::ErrorCode::OK;
+  }
+
+  /**
+   * @brief Sort combined buttons by key_count descending (Insertion Sort)
+   * @note Ties go to the combination with more excluded buttons, the more
+   * specific one, then to registration order. The sort is stable, so the
+   * order is total.
+   */
+  void SortCombinedButtons() {
+    if (total_count_ <= physical_count_ + 1) {
+      return;
+    }
+
+    auto less_specific = [](const GenericButton &a, const GenericButton &b) {
+      if (a.cfg.comb.key_count != b.cfg.comb.key_count) {
+        return a.cfg.comb.key_count < b.cfg.comb.key_count;
+      }
+      return CountBits(a.cfg.comb.care_mask) < CountBits(b.cfg.comb.care_mask);
+    };
+
+    for (size_t i = physical_count_ + 1; i < total_count_; ++i) {
+      GenericButton temp = all_buttons_[i];
+
+      size_t j = i;
+      while (j > physical_count_ && less_specific(all_buttons_[j - 1], temp)) {
+        all_buttons_[j] = all_buttons_[j - 1];
+        j--;
+      }
+      all_buttons_[j] = temp;
+    }
+  }
+
+  /**
+   * @brief Emit button event to queue and notify listeners
+   * @tparam TYPE Type of event that occurred, dropped at compile time when
+   * masked out by Traits::EVENT_MASK
+   * @param btn Reference to the button that triggered the event
+   * @param current_tick Tick time the event belongs to
+   */
+  template <ButtonEvent TYPE>
+  void EmitEvent(const GenericButton &btn, uint32_t current_tick) {
+    if constexpr (HAS_OVERLOAD_GUARD &&
+                  (Traits::OVERLOAD_SHED_EVENTS & BitsButtonEventBit(TYPE))) {
+      /* Hold repeats keep counting, the next delivered one coalesces them */
+      if (overloaded_) {
+        overload_stats_[0].shed_events++;
+        return;
+      }
+    }
+
+    if constexpr (IsEventEnabled(TYPE)) {
+      ButtonStateBits state_bits = 0;
+      uint16_t long_press_cnt = 0;
+      uint8_t velocity = 0;
+      if constexpr (HAS_CLICK_HISTORY) {
+        state_bits = btn.state_bits;
+      }
+      if constexpr (HAS_LONG_PRESS) {
+        long_press_cnt = btn.long_press_cnt;
+      }
+      if constexpr (HAS_VELOCITY && TYPE == ButtonEvent::PRESSED) {
+        velocity = ReadVelocity(btn);
+      }
+      uint8_t pressure_level = 0;
+      if constexpr (HAS_PRESSURE_LEVELS &&
+                    (TYPE == ButtonEvent::PRESSED ||
+                     TYPE == ButtonEvent::LONG_PRESS_HOLD)) {
+        if (btn.type == GenericButton::PHYSICAL) {
+          pressure_level = external_levels_[btn.logic_index].load(
+              std::memory_order_relaxed);
+        }
+      }
+
+      SubscriberMask subs = 0;
+      if constexpr (HAS_SUBSCRIBERS) {
+        subs = subscriber_map_[btn.logic_index][static_cast<uint8_t>(TYPE)];
+      }
+
+      PayloadHandle payload = INVALID_PAYLOAD;
+      bool shared_payload = false;
+      if constexpr (HAS_PAYLOAD &&
+                    (Traits::PAYLOAD_EVENTS & BitsButtonEventBit(TYPE))) {
+        /* A shared queue nobody reads would pin its slots for good */
+        shared_payload = shared_queue_read_.load(std::memory_order_relaxed);
+        if (shared_payload || subs != 0) {
+          payload = AttachPayload<TYPE>(btn, current_tick, subs,
+                                        shared_payload);
+        }
+      }
+
+      ButtonEventResult res = {btn.key_alias,
+                               TYPE,
+                               state_bits,
+                               long_press_cnt,
+                               current_tick,
+                               velocity,
+                               btn.logic_index,
+                               shared_payload ? payload : INVALID_PAYLOAD,
+                               pressure_level};
+
+      if constexpr (HAS_HISTORY) {
+        RecordEvent(res);
+      }
+      bool pushed = Deliver(result_queue_, 0, res);
+      Trace(pushed ? BitsButtonTracePoint::QUEUE_PUSH
+                   : BitsButtonTracePoint::QUEUE_DROP,
+            btn.logic_index, static_cast<uint32_t>(TYPE));
+      res.payload = payload;
+
+      while (subs != 0) {
+        ButtonIndexType id = LowestBitIndex(subs);
+        Deliver(SubscriberQueue(id), id + 1, res);
+        subs &= static_cast<SubscriberMask>(subs - 1);
+      }
+
+      button_events_.Active(MakeEventId(btn.logic_index, TYPE));
+    } else {
+      UNUSED(btn);
+      UNUSED(current_tick);
+    }
+  }
+
+  /**
+   * @brief Fill a pool slot for an event about to be queued
+   * @param subs Subscribers receiving the event
+   * @param shared True if the shared queue takes a reference too
+   * @return Payload handle holding one reference per receiving queue, or
+   * INVALID_PAYLOAD if the pool is exhausted
+   */
+  template <ButtonEvent TYPE>
+  PayloadHandle AttachPayload(const GenericButton &btn, uint32_t current_tick,
+                              SubscriberMask subs, bool shared) {
+    uint8_t refs = static_cast<uint8_t>(CountBits(subs) + (shared ? 1 : 0));
+
+    PayloadHandle handle = payload_pool_.Acquire(refs);
+    if (handle == INVALID_PAYLOAD) {
+      payload_misses_++;
+      return handle;
+    }
+
+    /* RELEASE keeps the release tick as its entry tick until RELEASED */
+    uint32_t end_tick = TYPE == ButtonEvent::RELEASED ? btn.state_entry_tick
+                                                      : current_tick;
+    EventPayload &payload = payload_pool_[handle];
+    payload.press_tick = btn.press_tick;
+    payload.held_ms = end_tick - btn.press_tick;
+    payload.contact_delta_us = 0;
+    payload.active_mask = current_mask_;
+    if constexpr (HAS_VELOCITY && TYPE == ButtonEvent::PRESSED) {
+      const VelocityContact *contact = FindVelocityContact(btn);
+      if (contact && contact->early_captured && contact->main_captured) {
+        payload.contact_delta_us = contact->main_us - contact->early_us;
+      }
+    }
+    return handle;
+  }
+
+  /**
+   * @brief Push an event and count the outcome
+   * @return True if the queue accepted the event
+   * @note A queue that rejects the event drops its payload reference.
+   */
+  bool Deliver(EventQueue &queue, size_t stats_slot,
+               const ButtonEventResult &res) {
+    LibXR::ErrorCode result = queue.Push(res);
+    CountPush(stats_slot, result);
+    if (result != LibXR::ErrorCode::OK) {
+      ReleasePayload(res.payload);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Append an event to the history ring
+   * @note The fence orders the previous counter store before the slot is
+   * overwritten, so CopyHistory() sees reuse through the counter.
+   */
+  void RecordEvent(const ButtonEventResult &res) {
+    uint32_t written = history_written_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    history_[written % HISTORY_SLOTS] = {res.system_tick, res.logic_index,
+                                         res.event_type, res.long_press_count};
+    history_written_.store(written + 1, std::memory_order_release);
+  }
+
+  void ReleasePayload(PayloadHandle handle) {
+    if constexpr (HAS_PAYLOAD) {
+      payload_pool_.Release(handle);
+    } else {
+      UNUSED(handle);
+    }
+  }
+
+  static uint8_t CountBits(ButtonMaskType mask) {
+    uint8_t count = 0;
+    for (; mask != 0; mask &= mask - 1) {
+      count++;
+    }
+    return count;
+  }
+
+  /**
+   * @brief Index of the lowest set bit
+   * @return BITS_BTN_INVALID_INDEX for an empty mask
+   * @note Used per edge, per layer move and per subscriber on the hot
+   * paths, so it is a count-trailing-zeros instruction where the compiler
+   * has one and a de Bruijn lookup elsewhere.
+   */
+  static ButtonIndexType LowestBitIndex(ButtonMaskType mask) {
+    if (mask == 0) {
+      return BITS_BTN_INVALID_INDEX;
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    if constexpr (sizeof(ButtonMaskType) <= sizeof(unsigned int)) {
+      return static_cast<ButtonIndexType>(
+          __builtin_ctz(static_cast<unsigned int>(mask)));
+    } else {
+      return static_cast<ButtonIndexType>(
+          __builtin_ctzll(static_cast<unsigned long long>(mask)));
+    }
+#else
+    constexpr uint8_t DE_BRUIJN[32] = {0,  1,  28, 2,  29, 14, 24, 3,
+                                       30, 22, 20, 15, 25, 17, 4,  8,
+                                       31, 27, 13, 23, 21, 19, 16, 7,
+                                       26, 12, 18, 6,  11, 5,  10, 9};
+    ButtonIndexType base = 0;
+    if constexpr (sizeof(ButtonMaskType) > sizeof(uint32_t)) {
+      if (static_cast<uint32_t>(mask) == 0) {
+        mask = static_cast<ButtonMaskType>(mask >> 16 >> 16);
+        base = 32;
+      }
+    }
+    uint32_t low = static_cast<uint32_t>(mask);
+    low &= ~low + 1; // Isolate the lowest set bit
+    return static_cast<ButtonIndexType>(
+        base + DE_BRUIJN[static_cast<uint32_t>(low * 0x077CB531U) >> 27]);
+#endif
+  }
+
+  /**
+   * @brief Count a wake episode and mask the line when it storms
+   * @param context Context of the line that fired
+   * @note Only the first edge of a line between two ticks is counted, so
+   * the bounce of a single press counts once. A masked line has its
+   * interrupt disabled and reads as inactive until the backoff expires, so
+   * a chattering switch costs at most STORM_EDGE_LIMIT wakeups per backoff
+   * period. The storm fields of the context are written here only; the
+   * tick reads storm_until after it saw the storm_mask_ bit.
+   */
+  void GuardEdgeFromIsr(IsrContext &context) {
+    if constexpr (HAS_STORM_GUARD) {
+      ButtonMaskType btn_bit = static_cast<ButtonMaskType>(1UL)
+                               << context.index;
+      if ((storm_edge_mask_.fetch_or(btn_bit, std::memory_order_relaxed) &
+           btn_bit) != 0) {
+        return; // Bounce of an edge not processed yet
+      }
+
+      auto now = static_cast<uint32_t>(LibXR::Timebase::GetMilliseconds());
+      if (now - context.window_start >= Traits::STORM_WINDOW_MS) {
+        context.window_start = now;
+        context.edge_count = 0;
+      }
+      if (++context.edge_count <= Traits::STORM_EDGE_LIMIT) {
+        return;
+      }
+
+      /* Exponential backoff, reset after a long quiet period */
+      if (now - context.storm_until > Traits::STORM_BACKOFF_MAX_MS) {
+        context.backoff_ms = Traits::STORM_BACKOFF_MS;
+      }
+      context.storm_until = now + context.backoff_ms;
+      context.backoff_ms = static_cast<uint16_t>(
+          context.backoff_ms * 2 > Traits::STORM_BACKOFF_MAX_MS
+              ? Traits::STORM_BACKOFF_MAX_MS
+              : context.backoff_ms * 2);
+      context.edge_count = 0; // Fresh window once the line is unmasked
+
+      all_buttons_[context.index].cfg.phys.gpio->DisableInterrupt();
+      storm_mask_.fetch_or(btn_bit, std::memory_order_release);
+      fault_pending_mask_.fetch_or(btn_bit, std::memory_order_relaxed);
+    } else {
+      UNUSED(context);
+    }
+  }
+
+  /**
+   * @brief Report new storms and unmask lines whose backoff expired
+   * @note Also starts the next edge counting period of all lines.
+   * @param now Tick time in ms
+   */
+  void ServiceStormLines(uint32_t now) {
+    if constexpr (HAS_STORM_GUARD) {
+      storm_edge_mask_.store(0, std::memory_order_relaxed);
+      ButtonMaskType faults =
+          fault_pending_mask_.exchange(0, std::memory_order_relaxed);
+      ButtonMaskType storms = storm_mask_.load(std::memory_order_acquire);
+      if ((faults | storms) == 0) {
+        return;
+      }
+
+      for (size_t i = 0; i < physical_count_; ++i) {
+        auto &btn = all_buttons_[i];
+        auto &context = isr_contexts_[btn.logic_index];
+        ButtonMaskType btn_bit = static_cast<ButtonMaskType>(1UL)
+                                 << btn.logic_index;
+
+        if (faults & btn_bit) {
+          EmitEvent<ButtonEvent::LINE_FAULT>(btn, now);
+        }
+        if ((storms & btn_bit) &&
+            static_cast<int32_t>(now - context.storm_until) >= 0) {
+          storm_mask_.fetch_and(~btn_bit, std::memory_order_relaxed);
+          if (interrupts_armed_) {
+            btn.cfg.phys.gpio->EnableInterrupt();
+          }
+        }
+      }
+    } else {
+      UNUSED(now);
+    }
+  }
+
+  /**
+   * @brief Start polling on an input change
+   * @param source Logic index of the line that changed, or
+   * BITS_BTN_INVALID_INDEX from a GPIO callback without HAS_ISR_CONTEXT
+   */
+  void WakeUpFromIsr(ButtonIndexType source) {
+    PowerState power = power_state_.load(std::memory_order_acquire);
+    if (power == PowerState::PARKED) {
+      /* A GPIO edge without its line can only come from an armed wake key */
+      bool wake_key =
+          source == BITS_BTN_INVALID_INDEX ||
+          (wake_mask_ & (static_cast<ButtonMaskType>(1UL) << source)) != 0;
+      if (wake_key && power_state_.compare_exchange_strong(
+                          power, PowerState::RESUME_PENDING)) {
+        LibXR::Timer::Start(state_timer_);
+      }
+      return;
+    }
+    if (power == PowerState::RESUME_PENDING) {
+      return; // The resuming tick re-reads every input
+    }
+
+    if (is_polling_active_) {
+      next_deadline_ = last_tick_; // Edge on a settled input, due now
+      return;
+    }
+
+    if constexpr (HAS_WAKE_STATS) {
+      wake_accounting_[0].episode.wake_source = source;
+    }
+    Trace(BitsButtonTracePoint::WAKE, source, 0);
+
+    /* The idle scan or a storm wait may have stretched the period */
+    LibXR::Timer::SetCycle(state_timer_, TIMER_INTERVAL_MS);
+    LibXR::Timer::Start(state_timer_);
+    is_polling_active_ = true;
+    idle_hysteresis_ = 0;
+    next_deadline_ = last_tick_;     // Overdue, process on the next tick
+    interrupts_need_disable_ = true; // Interrupts to be disabling
+  }
+
+  /**
+   * @brief Keep the timer running while asleep, for polled or masked lines
+   * @param now Tick time in ms
+   * @note Polled inputs are scanned at the low idle rate. Masked storm lines
+   * alone need no scan, only their unmasking, so the timer then fires once
+   * at the earliest re-enable deadline.
+   */
+  void StartIdleScan(uint32_t now) {
+    uint32_t interval = polled_input_mask_ != 0 ? Traits::IDLE_SCAN_INTERVAL_MS
+                                                : StormReenableDelay(now);
+    LibXR::Timer::SetCycle(state_timer_, interval);
+    LibXR::Timer::Start(state_timer_);
+    next_deadline_ = now + interval;
+  }
+
+  /**
+   * @brief Time until the first masked storm line is re-enabled
+   * @param now Tick time in ms
+   * @return Delay in ms, at least one
+   */
+  uint32_t StormReenableDelay(uint32_t now) const {
+    uint32_t delay = Traits::IDLE_SCAN_INTERVAL_MS;
+    if constexpr (HAS_STORM_GUARD) {
+      bool found = false;
+      ButtonMaskType storms = storm_mask_.load(std::memory_order_acquire);
+      for (; storms != 0; storms &= storms - 1) {
+        int32_t left = static_cast<int32_t>(
+            isr_contexts_[LowestBitIndex(storms)].storm_until - now);
+        uint32_t remaining = left > 1 ? static_cast<uint32_t>(left) : 1;
+        if (!found || remaining < delay) {
+          delay = remaining;
+        }
+        found = true;
+      }
+    } else {
+      UNUSED(now);
+    }
+    return delay;
+  }
+
+  /**
+   * @brief Switch edge interrupts of the GPIO inputs on or off
+   * @param arm True to enable, false to disable
+   * @note Dual-contact keys are left armed, they timestamp every edge.
+   */
+  void ArmInterrupts(bool arm) {
+    if (arm == interrupts_armed_) {
+      return;
+    }
+
+    for (size_t i = 0; i < physical_count_; ++i) {
+      auto &btn = all_buttons_[i];
+      ButtonMaskType btn_bit = static_cast<ButtonMaskType>(1UL)
+                               << btn.logic_index;
+      if ((interrupt_mask_ & ~velocity_mask_ & ~storm_mask_ & btn_bit) == 0) {
+        continue;
+      }
+      if (arm) {
+        btn.cfg.phys.gpio->EnableInterrupt();
+      } else {
+        btn.cfg.phys.gpio->DisableInterrupt();
+      }
+    }
+    interrupts_armed_ = arm;
+  }
+
+  /**
+   * @brief Flush button states and leave only the wake keys armed
+   * @param now Tick time in ms
+   */
+  void Park(uint32_t now) {
+    LibXR::Timer::Stop(state_timer_);
+    LibXR::Timer::SetCycle(state_timer_, TIMER_INTERVAL_MS);
+
+    /* Close open presses so no consumer sees a key stuck down */
+    for (size_t i = 0; i < total_count_; ++i) {
+      auto &btn = all_buttons_[i];
+      if (btn.type == GenericButton::PHYSICAL && btn.cfg.phys.is_switch) {
+        continue;
+      }
+      if (btn.current_state == InternalState::PRESSED ||
+          btn.current_state == InternalState::LONG_PRESS ||
+          btn.current_state == InternalState::RELEASE) {
+        EmitEvent<ButtonEvent::RELEASED>(btn, now);
+      }
+      btn.current_state = InternalState::IDLE;
+      ClearHistory(btn);
+      ClearLongPressCount(btn);
+      if constexpr (HAS_SUPPRESSION) {
+        if (btn.type == GenericButton::PHYSICAL) {
+          btn.cfg.phys.pending_press_tick = 0;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < physical_count_; ++i) {
+      auto &btn = all_buttons_[i];
+      if ((interrupt_mask_ & (static_cast<ButtonMaskType>(1UL)
+                              << btn.logic_index)) == 0) {
+        continue;
+      }
+      btn.cfg.phys.gpio->DisableInterrupt();
+      if constexpr (HAS_VELOCITY) {
+        if (const VelocityContact *contact = FindVelocityContact(btn)) {
+          contact->early_gpio->DisableInterrupt();
+        }
+      }
+    }
+    interrupts_armed_ = false;
+
+    if constexpr (HAS_WAKE_STATS) {
+      if (is_polling_active_) {
+        FinishWakeEpisode();
+      }
+    }
+    if constexpr (HAS_ADAPTIVE_SLEEP) {
+      gap_open_ = false; // A parked period is no idle gap
+    }
+    is_polling_active_ = false;
+    next_deadline_ = DEADLINE_NEVER;
+    Trace(BitsButtonTracePoint::SLEEP, BITS_BTN_INVALID_INDEX, 0);
+
+    /* A Resume() that raced with parking finds the timer stopped */
+    PowerState expected = PowerState::PARK_PENDING;
+    if (!power_state_.compare_exchange_strong(expected, PowerState::PARKED,
+                                              std::memory_order_acq_rel)) {
+      LibXR::Timer::Start(state_timer_);
+      return;
+    }
+
+    /* Armed only now, so a wake edge always sees PARKED */
+    for (size_t i = 0; i < physical_count_; ++i) {
+      auto &btn = all_buttons_[i];
+      ButtonMaskType btn_bit = static_cast<ButtonMaskType>(1UL)
+                               << btn.logic_index;
+      if ((wake_mask_ & interrupt_mask_ & ~storm_mask_ & btn_bit) != 0) {
+        btn.cfg.phys.gpio->EnableInterrupt();
+      }
+    }
+  }
 
-    /* Hardware Config */
-    auto dir = LibXR::GPIO::Direction::FALL_RISING_INTERRUPT;
-    auto pull =
-        cfg.active_level ? LibXR::GPIO::Pull::DOWN : LibXR::GPIO::Pull::UP;
-    gpio_handle->SetConfig({dir, pull});
+  /**
+   * @brief Leave the parked state from one batched read of all inputs
+   * @param raw_mask Inputs sampled by the resuming tick
+   */
+  void Unpark(ButtonMaskType raw_mask) {
+    for (size_t i = 0; i < physical_count_; ++i) {
+      auto &btn = all_buttons_[i];
+      bool level = (raw_mask & (static_cast<ButtonMaskType>(1UL)
+                                << btn.logic_index)) != 0;
+      btn.cfg.phys.last_raw_state = level;
+      btn.cfg.phys.debounced_state = level;
+      btn.debounce_counter = DEBOUNCE_THRESHOLD;
+
+      /* Dual-contact keys stay armed while awake */
+      if constexpr (HAS_VELOCITY) {
+        const VelocityContact *contact = FindVelocityContact(btn);
+        if (contact && (storm_mask_ & (static_cast<ButtonMaskType>(1UL)
+                                       << btn.logic_index)) == 0) {
+          btn.cfg.phys.gpio->EnableInterrupt();
+          contact->early_gpio->EnableInterrupt();
+        }
+      }
+    }
+    last_raw_mask_ = raw_mask;
 
-    /* Callback Registration */
-    auto gpio_callback = LibXR::GPIO::Callback::Create(
-        [](bool, BitsButtonXR *instance) { instance->WakeUpFromIsr(); }, this);
-    gpio_handle->RegisterCallback(gpio_callback);
-    gpio_handle->EnableInterrupt();
+    ButtonIndexType source = LowestBitIndex(raw_mask & wake_mask_);
+    if constexpr (HAS_WAKE_STATS) {
+      wake_accounting_[0].episode.wake_source = source;
+    }
+    Trace(BitsButtonTracePoint::WAKE, source, 0);
 
-    physical_count_++;
-    total_count_++;
-    return LibXR::ErrorCode::OK;
+    /* The wake keys are disabled with the others by the tick */
+    interrupts_armed_ = true;
+    interrupts_need_disable_ = true;
+    is_polling_active_ = true;
+    idle_hysteresis_ = 0;
+    power_state_.store(PowerState::AWAKE, std::memory_order_release);
   }
 
-  /**
-   * @brief Helper: Resolve a string alias to a logical index
-   * Only searches currently initialized PHYSICAL buttons.
-   */
-  uint8_t ResolveAliasToIndex(const char *alias) {
-    if (!alias) {
-      return BITS_BTN_INVALID_INDEX;
+  void EnterSleepMode() {
+    if ((polled_input_mask_ | storm_mask_) != 0) {
+      StartIdleScan(last_tick_);
+    } else {
+      LibXR::Timer::Stop(state_timer_);
+      next_deadline_ = DEADLINE_NEVER;
     }
+    is_polling_active_ = false;
+    Trace(BitsButtonTracePoint::SLEEP, BITS_BTN_INVALID_INDEX, 0);
 
-    for (uint8_t i = 0; i < physical_count_; ++i) {
-      if (all_buttons_[i].type == GenericButton::PHYSICAL &&
-          all_buttons_[i].key_alias &&
-          strcmp(all_buttons_[i].key_alias, alias) == 0) {
-        return all_buttons_[i].logic_index;
-      }
+    if constexpr (HAS_WAKE_STATS) {
+      FinishWakeEpisode();
     }
-    return BITS_BTN_INVALID_INDEX;
+
+    /* Enable interrupts for all physical buttons */
+    ArmInterrupts(true);
   }
 
   /**
-   * @brief Initialize a combined button using aliases
-   * @param cfg Combined button configuration
-   * @return ErrorCode indicating success or failure
+   * @brief Time-driven deadline of one button, assuming stable inputs
+   * @param btn Button to inspect
+   * @param now Tick time in ms
+   * @param deadline Tick at which the button changes state without an edge
+   * @return False if only an input edge can change the button
    */
-  LibXR::ErrorCode InitCombinedButton(const CombinedButtonConfig &cfg) {
-    /* Calculate Mask by resolving aliases */
-    ButtonMaskType mask = 0;
-    uint8_t valid_key_count = 0;
+  bool ButtonDeadline(const GenericButton &btn, uint32_t now,
+                      uint32_t &deadline) const {
+    const auto &constraints = btn.constraints;
 
-    for (const char *alias : cfg.constituent_aliases) {
-      uint8_t idx = ResolveAliasToIndex(alias);
+    switch (btn.current_state) {
+    case InternalState::IDLE:
+      if constexpr (HAS_SUPPRESSION) {
+        if (btn.type == GenericButton::PHYSICAL &&
+            btn.cfg.phys.pending_press_tick != 0) {
+          deadline = btn.cfg.phys.pending_press_tick + COMBINED_COMMIT_DELAY_MS;
+          return true;
+        }
+      }
+      return false;
 
-      if (idx == BITS_BTN_INVALID_INDEX) {
-        return LibXR::ErrorCode::NOT_FOUND;
+    case InternalState::PRESSED:
+      if (!HAS_LONG_PRESS ||
+          (btn.type == GenericButton::PHYSICAL && btn.cfg.phys.is_switch)) {
+        return false;
       }
+      deadline =
+          btn.state_entry_tick + constraints.long_press_start_time_ms + 1;
+      return true;
 
-      mask |= static_cast<ButtonMaskType>(1UL) << idx;
-      valid_key_count++;
-    }
+    case InternalState::LONG_PRESS:
+      deadline =
+          btn.state_entry_tick + constraints.long_press_period_triger_ms + 1;
+      return true;
 
-    if (valid_key_count == 0) {
-      return LibXR::ErrorCode::ARG_ERR;
+    case InternalState::RELEASE_WINDOW:
+      deadline = btn.state_entry_tick + constraints.time_window_time_ms + 1;
+      return true;
+
+    case InternalState::RELEASE:
+    case InternalState::FINISH:
+      deadline = now;
+      return true;
     }
+    return false;
+  }
 
-    /* Setup the object */
-    auto &btn = all_buttons_[total_count_];
+  /**
+   * @brief Recompute NextDeadline() at the end of a tick
+   * @param settled True if every raw input matches its debounced level
+   * @param now Tick time in ms
+   * @param idle True if no button holds the module awake
+   */
+  void UpdateDeadline(bool settled, uint32_t now, bool idle) {
+    uint32_t next_tick = now + TIMER_INTERVAL_MS;
+
+    /* Inputs still settling must be sampled every tick, and so must GPIO
+     * inputs whose interrupts stay masked until sleep */
+    if constexpr (HAS_TICKLESS_IDLE) {
+      ArmInterrupts(settled);
+    } else if ((interrupt_mask_ & ~velocity_mask_) != 0) {
+      settled = false;
+    }
+    if (!settled) {
+      next_deadline_ = next_tick;
+      return;
+    }
 
-    btn.type = GenericButton::COMBINED;
-    btn.key_alias = cfg.combined_alias;
-    btn.logic_index = total_count_;
-    btn.constraints = cfg.constraints;
-    ResetState(btn);
+    auto before = [](uint32_t a, uint32_t b) {
+      return static_cast<int32_t>(a - b) < 0;
+    };
+    auto for_each_deadline = [&](auto &&visit) {
+      uint32_t deadline = 0;
+      for (size_t i = 0; i < total_count_; ++i) {
+        if (ButtonDeadline(all_buttons_[i], now, deadline)) {
+          visit(before(deadline, next_tick) ? next_tick : deadline);
+        }
+      }
+      if (idle) {
+        visit(now + (sleep_threshold_ + 1 - idle_hysteresis_) *
+                        TIMER_INTERVAL_MS);
+      }
+    };
 
-    btn.cfg.comb.mask = mask;
-    btn.cfg.comb.suppress_single = cfg.suppress_single_keys;
-    btn.cfg.comb.key_count = valid_key_count;
+    bool found = false;
+    uint32_t earliest = DEADLINE_NEVER;
+    for_each_deadline([&](uint32_t deadline) {
+      if (!found || before(deadline, earliest)) {
+        earliest = deadline;
+      }
+      found = true;
+    });
+    if (!found) {
+      next_deadline_ = DEADLINE_NEVER;
+      return;
+    }
 
-    total_count_++;
-    return LibXR::ErrorCode::OK;
+    /* Coalesce: postpone to the last deadline within the slack */
+    uint32_t limit = earliest + timer_slack_ms_;
+    uint32_t merged = earliest;
+    for_each_deadline([&](uint32_t deadline) {
+      if (!before(limit, deadline) && before(merged, deadline)) {
+        merged = deadline;
+      }
+    });
+    next_deadline_ = merged;
   }
 
   /**
-   * @brief Sort combined buttons by key_count descending (Insertion Sort)
+   * @brief Learn the idle-to-next-activity gaps and pick the sleep hysteresis
+   * @param idle True if no button holds the module awake in this tick
+   * @param now Tick time in ms
+   * @note Gaps that outlast a sleep are measured up to the tick after the
+   * wakeup, so sporadic use lands in the overflow bin.
    */
-  void SortCombinedButtons() {
-    if (total_count_ <= physical_count_ + 1) {
+  void TrackIdleGap(bool idle, uint32_t now) {
+    if (idle) {
+      if (!gap_open_) {
+        gap_open_ = true;
+        idle_since_ = now;
+      }
       return;
     }
+    if (!gap_open_) {
+      return;
+    }
+    gap_open_ = false;
 
-    for (size_t i = physical_count_ + 1; i < total_count_; ++i) {
-      GenericButton temp = all_buttons_[i];
-      uint8_t temp_count = temp.cfg.comb.key_count;
-
-      size_t j = i;
-      while (j > physical_count_ &&
-             all_buttons_[j - 1].cfg.comb.key_count < temp_count) {
-        all_buttons_[j] = all_buttons_[j - 1];
-        j--;
+    uint32_t gap_ticks = (now - idle_since_) / TIMER_INTERVAL_MS;
+    if (gap_ticks > Traits::ADAPTIVE_SLEEP_MAX_TICKS) {
+      gap_ticks = Traits::ADAPTIVE_SLEEP_MAX_TICKS;
+    }
+    gap_histogram_[gap_ticks]++;
+    gap_samples_++;
+
+    if (gap_samples_ >= GAP_DECAY_SAMPLES) {
+      gap_samples_ = 0;
+      for (auto &count : gap_histogram_) {
+        count = static_cast<uint8_t>(count >> 1);
+        gap_samples_ = static_cast<uint8_t>(gap_samples_ + count);
       }
-      all_buttons_[j] = temp;
+    }
+    if (gap_samples_ >= GAP_WARMUP_SAMPLES) {
+      sleep_threshold_ = BestSleepThreshold();
     }
   }
 
   /**
-   * @brief Emit button event to queue and notify listeners
-   * @param btn Reference to the button that triggered the event
-   * @param type Type of event that occurred
+   * @brief Hysteresis with the lowest expected cost over the learned gaps
+   * @return Idle ticks before sleeping
+   * @note A gap shorter than the hysteresis costs its length in awake
+   * ticks, a longer one costs the hysteresis plus SLEEP_WAKE_COST_TICKS.
    */
-  void EmitEvent(const GenericButton &btn, ButtonEvent type) {
-    ButtonEventResult res = {btn.key_alias, type, btn.state_bits,
-                             btn.long_press_cnt, LibXR::Thread::GetTime()};
-
-    result_queue_.Push(res);
-
-    button_events_.Active(MakeEventId(btn.logic_index, type));
+  uint16_t BestSleepThreshold() const {
+    uint32_t shorter_ticks = 0; // Sum of gaps below the candidate
+    uint32_t longer_count = gap_samples_;
+    uint32_t best_cost = UINT32_MAX;
+    uint16_t best = 0;
+
+    for (uint16_t h = 0; h <= Traits::ADAPTIVE_SLEEP_MAX_TICKS; ++h) {
+      uint32_t cost =
+          shorter_ticks + longer_count * (h + Traits::SLEEP_WAKE_COST_TICKS);
+      if (cost < best_cost) {
+        best_cost = cost;
+        best = h;
+      }
+      if (h < Traits::ADAPTIVE_SLEEP_MAX_TICKS) {
+        shorter_ticks += static_cast<uint32_t>(gap_histogram_[h]) * h;
+        longer_count -= gap_histogram_[h];
+      }
+    }
+    return best;
   }
 
-  void WakeUpFromIsr() {
-    if (is_polling_active_) {
-      return;
+  /**
+   * @brief Account one polled tick to the current wake episode
+   * @param now Tick time in ms
+   */
+  void AccountWakeTick(uint32_t now) {
+    auto &acct = wake_accounting_[0];
+    if (acct.episode.polled_ticks == 0) {
+      acct.episode_start_tick = now;
+    }
+    acct.episode.polled_ticks++;
+    acct.episode.awake_ms = now - acct.episode_start_tick + TIMER_INTERVAL_MS;
+
+    /* Attribute the tick to every button that holds the module awake */
+    bool attributed = false;
+    for (size_t i = 0; i < total_count_; ++i) {
+      const auto &btn = all_buttons_[i];
+      bool alive = btn.current_state != InternalState::IDLE;
+      if (i < physical_count_) {
+        ButtonMaskType btn_bit = static_cast<ButtonMaskType>(1UL)
+                                 << btn.logic_index;
+        if (switch_mask_ & btn_bit) {
+          continue;
+        }
+        alive = alive || (current_mask_ & btn_bit) != 0;
+      }
+      if (alive) {
+        acct.alive_ticks[i]++;
+        attributed = true;
+      }
     }
 
-    LibXR::Timer::Start(state_timer_);
-    is_polling_active_ = true;
-    idle_hysteresis_ = 0;
-    interrupts_need_disable_ = true; // Interrupts to be disabling
+    if (!attributed) {
+      acct.stats.hysteresis_ticks++;
+    }
   }
 
-  void EnterSleepMode() {
-    LibXR::Timer::Stop(state_timer_);
-    is_polling_active_ = false;
-
-    /* Enable interrupts for all physical buttons */
-    for (size_t i = 0; i < physical_count_; ++i) {
-      auto &btn = all_buttons_[i];
-      if (btn.type == GenericButton::PHYSICAL && btn.cfg.phys.gpio) {
-        btn.cfg.phys.gpio->EnableInterrupt();
+  /**
+   * @brief Close the current wake episode and fold it into the aggregates
+   */
+  void FinishWakeEpisode() {
+    auto &acct = wake_accounting_[0];
+    auto &episode = acct.episode;
+    uint32_t longest = 0;
+    episode.keep_alive_button = BITS_BTN_INVALID_INDEX;
+
+    for (size_t i = 0; i < total_count_; ++i) {
+      if (acct.alive_ticks[i] > longest) {
+        longest = acct.alive_ticks[i];
+        episode.keep_alive_button = all_buttons_[i].logic_index;
       }
+      acct.stats.keep_alive_ticks[all_buttons_[i].logic_index] +=
+          acct.alive_ticks[i];
+      acct.alive_ticks[i] = 0;
     }
+
+    acct.stats.wake_count++;
+    acct.stats.polled_ticks += episode.polled_ticks;
+    acct.stats.awake_ms += episode.awake_ms;
+    if (episode.wake_source < BITS_BTN_MAX_SINGLES) {
+      acct.stats.wakes_by_button[episode.wake_source]++;
+    }
+    acct.stats.last_episode = episode;
+
+    episode = {BITS_BTN_INVALID_INDEX, BITS_BTN_INVALID_INDEX, 0, 0};
   }
 
   /**
@@ -488,8 +2849,11 @@ private:
       if (is_active) {
         btn.current_state = InternalState::PRESSED;
         btn.state_entry_tick = current_tick;
+        if constexpr (HAS_PAYLOAD) {
+          btn.press_tick = current_tick;
+        }
         RecordHistory(btn, true);
-        EmitEvent(btn, ButtonEvent::PRESSED);
+        EmitEvent<ButtonEvent::PRESSED>(btn, current_tick);
       }
       break;
 
@@ -497,51 +2861,99 @@ private:
       if (!is_active) {
         btn.current_state = InternalState::RELEASE;
         btn.state_entry_tick = current_tick;
-      } else if (elapsed_ms > btn.constraints.long_press_start_time_ms) {
-        btn.current_state = InternalState::LONG_PRESS;
-        btn.state_entry_tick = current_tick;
-        btn.long_press_cnt = 0;
-        RecordHistory(btn, true);
-        EmitEvent(btn, ButtonEvent::LONG_PRESS_START);
+      } else if constexpr (HAS_LONG_PRESS) {
+        if (elapsed_ms > btn.constraints.long_press_start_time_ms) {
+          btn.current_state = InternalState::LONG_PRESS;
+          btn.state_entry_tick = current_tick;
+          btn.long_press_cnt = 0;
+          RecordHistory(btn, true);
+          EmitEvent<ButtonEvent::LONG_PRESS_START>(btn, current_tick);
+        }
       }
       break;
 
+    /* Unreachable states below fold into empty cases when compiled out */
     case InternalState::LONG_PRESS:
-      if (!is_active) {
-        btn.current_state = InternalState::RELEASE;
-        btn.state_entry_tick = current_tick;
-      } else if (elapsed_ms > btn.constraints.long_press_period_triger_ms) {
-        btn.state_entry_tick = current_tick;
-        btn.long_press_cnt++;
-        RecordHistory(btn, true);
-        EmitEvent(btn, ButtonEvent::LONG_PRESS_HOLD);
+      if constexpr (HAS_LONG_PRESS) {
+        if (!is_active) {
+          btn.current_state = InternalState::RELEASE;
+          btn.state_entry_tick = current_tick;
+        } else if (elapsed_ms > btn.constraints.long_press_period_triger_ms) {
+          btn.state_entry_tick = current_tick;
+          btn.long_press_cnt++;
+          RecordHistory(btn, true);
+          EmitEvent<ButtonEvent::LONG_PRESS_HOLD>(btn, current_tick);
+        }
       }
       break;
 
-    case InternalState::RELEASE:
+    case InternalState::RELEASE: {
+      uint32_t release_tick = current_tick;
+      if constexpr (HAS_SAMPLE_TIMESTAMPS) {
+        if (btn.type == GenericButton::PHYSICAL &&
+            (stamped_release_mask_ &
+             (static_cast<ButtonMaskType>(1UL) << btn.logic_index)) != 0) {
+          release_tick = btn.state_entry_tick;
+        }
+      }
       RecordHistory(btn, false);
-      EmitEvent(btn, ButtonEvent::RELEASED);
+      EmitEvent<ButtonEvent::RELEASED>(btn, release_tick);
 
-      btn.current_state = InternalState::RELEASE_WINDOW;
-      btn.state_entry_tick = current_tick;
+      if constexpr (HAS_CLICK_WINDOW) {
+        btn.current_state = InternalState::RELEASE_WINDOW;
+        btn.state_entry_tick = current_tick;
+      } else {
+        /* No click window: the click sequence ends with the release */
+        ClearHistory(btn);
+        btn.current_state = InternalState::IDLE;
+      }
       break;
+    }
 
     case InternalState::RELEASE_WINDOW:
-      if (is_active) {
-        btn.current_state = InternalState::IDLE;
-      } else if (elapsed_ms > btn.constraints.time_window_time_ms) {
-        btn.current_state = InternalState::FINISH;
+      if constexpr (HAS_CLICK_WINDOW) {
+        if (is_active) {
+          btn.current_state = InternalState::IDLE;
+        } else if (elapsed_ms > btn.constraints.time_window_time_ms) {
+          btn.current_state = InternalState::FINISH;
+        }
       }
       break;
 
     case InternalState::FINISH:
-      EmitEvent(btn, ButtonEvent::CLICK_FINISH);
-      btn.state_bits = 0;
-      btn.current_state = InternalState::IDLE;
+      if constexpr (HAS_CLICK_WINDOW) {
+        EmitEvent<ButtonEvent::CLICK_FINISH>(btn, current_tick);
+        ClearHistory(btn);
+        btn.current_state = InternalState::IDLE;
+      }
       break;
     }
   }
 
+  /**
+   * @brief Level-only fast path for switch inputs, no timers or history
+   * @param btn Reference to the switch button
+   * @param is_on Current debounced level
+   * @param current_tick Current system tick time
+   */
+  void UpdateSwitchState(GenericButton &btn, bool is_on,
+                         uint32_t current_tick) {
+    bool was_on = btn.current_state != InternalState::IDLE;
+    if (is_on == was_on) {
+      return;
+    }
+
+    btn.current_state = is_on ? InternalState::PRESSED : InternalState::IDLE;
+    btn.state_entry_tick = current_tick;
+    Trace(BitsButtonTracePoint::STATE, btn.logic_index,
+          static_cast<uint32_t>(btn.current_state));
+    if (is_on) {
+      EmitEvent<ButtonEvent::SWITCH_ON>(btn, current_tick);
+    } else {
+      EmitEvent<ButtonEvent::SWITCH_OFF>(btn, current_tick);
+    }
+  }
+
   /**
    * @brief Update debounced state for a physical button
    * @param btn Reference to the button structure
@@ -566,125 +2978,364 @@ private:
 
   /**
    * @brief Timer callback function for button state management
-   * @param instance Pointer to the BitsButtonXR instance
+   * @param instance Pointer to the BasicBitsButtonXR instance
    */
-  static void StateTimerOnTick(BitsButtonXR *instance) {
+  static void StateTimerOnTick(BasicBitsButtonXR *instance) {
     uint32_t now = LibXR::Thread::GetTime();
+    PowerState power = instance->power_state_.load(std::memory_order_acquire);
+    if (power == PowerState::PARK_PENDING) {
+      instance->Park(now);
+      return;
+    }
+    if (power == PowerState::PARKED) {
+      return; // Tick already queued when the timer stopped
+    }
+
+    if constexpr (HAS_STORM_GUARD) {
+      instance->ServiceStormLines(now);
+    }
+    ButtonMaskType raw_mask = instance->SampleInputs();
+    if (power == PowerState::RESUME_PENDING) {
+      instance->Unpark(raw_mask);
+    }
 
-    // Disable interrupts if needed
-    if (instance->interrupts_need_disable_) {
-      for (size_t i = 0; i < instance->physical_count_; ++i) {
-        auto &btn = instance->all_buttons_[i];
-        if (btn.type == GenericButton::PHYSICAL && btn.cfg.phys.gpio) {
-          btn.cfg.phys.gpio->DisableInterrupt();
+    /* Idle scan: stay asleep unless an input without interrupt changed */
+    if (!instance->is_polling_active_) {
+      ButtonMaskType changed = (raw_mask ^ instance->last_raw_mask_) &
+                               instance->polled_input_mask_;
+      if constexpr (HAS_WAKE_STATS) {
+        instance->wake_accounting_[0].stats.idle_scan_ticks++;
+      }
+      if (changed == 0) {
+        if ((instance->polled_input_mask_ | instance->storm_mask_) == 0) {
+          /* Last storm line unmasked, nothing left to scan */
+          LibXR::Timer::Stop(instance->state_timer_);
+          instance->next_deadline_ = DEADLINE_NEVER;
+          if (instance->is_polling_active_) {
+            LibXR::Timer::Start(instance->state_timer_); // Raced with an edge
+          }
+        } else {
+          instance->StartIdleScan(now);
+          if (instance->is_polling_active_) {
+            /* Raced with an edge, poll at the tick rate */
+            LibXR::Timer::SetCycle(instance->state_timer_, TIMER_INTERVAL_MS);
+          }
         }
+        return;
       }
+      instance->WakeUpFromIsr(LowestBitIndex(changed));
+    }
+
+    // Disable interrupts if needed, dual-contact keys keep timestamping
+    bool resumed = instance->interrupts_need_disable_;
+    if (resumed) {
+      instance->ArmInterrupts(false);
       instance->interrupts_need_disable_ = false;
     }
 
+    if constexpr (HAS_OVERLOAD_GUARD) {
+      /* The first tick after a wakeup has no previous tick to be late to */
+      bool late = !resumed && instance->IsLateTick(now);
+      uint32_t start_us = NowUs();
+      instance->ProcessTick(raw_mask, now);
+      instance->AccountTickLoad(NowUs() - start_us, late);
+    } else {
+      instance->ProcessTick(raw_mask, now);
+    }
+  }
+
+  /**
+   * @brief Check whether a tick runs a whole period after it was due
+   * @param now Tick time in ms
+   * @return True if at least one timer period was missed
+   * @note Due is the next period or, when later, the deadline requested by
+   * the previous tick, so tickless sleeping is not mistaken for lateness.
+   */
+  bool IsLateTick(uint32_t now) const {
+    uint32_t due = last_tick_ + TIMER_INTERVAL_MS;
+    uint32_t wanted = next_deadline_.load(std::memory_order_relaxed);
+    if (wanted != DEADLINE_NEVER && static_cast<int32_t>(wanted - due) > 0) {
+      due = wanted;
+    }
+    return static_cast<int32_t>(now - due) >=
+           static_cast<int32_t>(TIMER_INTERVAL_MS);
+  }
+
+  /**
+   * @brief Enter or leave the degraded mode from the load of one tick
+   * @param tick_us Time spent in ProcessTick, listener callbacks included
+   * @param late True if the tick itself started late
+   */
+  void AccountTickLoad(uint32_t tick_us, bool late) {
+    auto &stats = overload_stats_[0];
+    if (tick_us > stats.max_tick_us) {
+      stats.max_tick_us = tick_us;
+    }
+    bool overrun = tick_us > Traits::OVERLOAD_BUDGET_US;
+    if (overrun) {
+      stats.overrun_ticks++;
+    }
+    if (late) {
+      stats.late_ticks++;
+    }
+
+    if (overrun || late) {
+      healthy_ticks_ = 0;
+      if (!overloaded_) {
+        overloaded_ = true;
+        stats.overload_count++;
+      }
+    } else if (overloaded_ &&
+               ++healthy_ticks_ >= Traits::OVERLOAD_RECOVER_TICKS) {
+      overloaded_ = false;
+    }
+  }
+
+  /**
+   * @brief Read all physical inputs in one pass
+   * @return Raw active mask, bit set when the GPIO is at its active level
+   */
+  ButtonMaskType SampleInputs() {
+    ButtonMaskType raw_mask =
+        external_active_mask_.load(std::memory_order_acquire) &
+        external_input_mask_;
+    ButtonMaskType storm_mask = storm_mask_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < physical_count_; ++i) {
+      auto &btn = all_buttons_[i];
+      if (btn.cfg.phys.gpio &&
+          btn.cfg.phys.gpio->Read() == btn.cfg.phys.active_level) {
+        raw_mask |= static_cast<ButtonMaskType>(1UL) << btn.logic_index;
+      }
+    }
+
+    /* Lines masked by the storm guard read as inactive */
+    return raw_mask & ~storm_mask;
+  }
+
+  /**
+   * @brief Debounce, combined matching and state machines for one tick
+   * @param raw_mask Raw active mask of the physical buttons
+   * @param now Tick time in ms
+   */
+  void ProcessTick(ButtonMaskType raw_mask, uint32_t now) {
+    uint32_t prev_tick = last_tick_;
+    raw_mask &= ~layer_output_mask_;
+    Trace(BitsButtonTracePoint::TICK_BEGIN, BITS_BTN_INVALID_INDEX, raw_mask);
+    if constexpr (HAS_TRACE) {
+      for (ButtonMaskType changed = raw_mask ^ last_raw_mask_; changed != 0;
+           changed &= changed - 1) {
+        ButtonIndexType index = LowestBitIndex(changed);
+        Trace(BitsButtonTracePoint::RAW_EDGE, index, (raw_mask >> index) & 1U);
+      }
+    }
+    last_raw_mask_ = raw_mask;
+    last_tick_ = now;
+
     /* Update debounced state for physical buttons + build current mask */
-    instance->current_mask_ = 0;
-    for (size_t i = 0; i < instance->physical_count_; ++i) {
-      auto &btn = instance->all_buttons_[i];
-      bool gpio_read = btn.cfg.phys.gpio->Read();
-      bool raw_state = gpio_read == btn.cfg.phys.active_level;
-      instance->UpdateButtonDebounce(btn, raw_state);
+    current_mask_ = 0;
+    for (size_t i = 0; i < physical_count_; ++i) {
+      auto &btn = all_buttons_[i];
+      bool raw_state =
+          (raw_mask & (static_cast<ButtonMaskType>(1UL) << btn.logic_index)) !=
+          0;
+      [[maybe_unused]] bool was_debounced = btn.cfg.phys.debounced_state;
+      UpdateButtonDebounce(btn, raw_state);
+      if constexpr (HAS_TRACE) {
+        if (btn.cfg.phys.debounced_state != was_debounced) {
+          Trace(BitsButtonTracePoint::DEBOUNCED, btn.logic_index,
+                btn.cfg.phys.debounced_state);
+        }
+      }
 
       if (btn.cfg.phys.debounced_state) {
-        instance->current_mask_ |=
+        current_mask_ |=
             (static_cast<ButtonMaskType>(1UL) << btn.logic_index);
       }
     }
 
+    /* A line masked by the storm guard counts as settled until unmasked */
+    StepStates(((raw_mask ^ current_mask_) & ~storm_mask_) == 0, prev_tick,
+               now);
+  }
+
+  /**
+   * @brief Layers, combined matching, state machines and sleep of one step
+   * @param settled Raw levels equal the debounced current_mask_
+   * @param prev_tick Time of the previous step
+   * @param now Tick time in ms
+   */
+  void StepStates(bool settled, uint32_t prev_tick, uint32_t now) {
+    /* Layer stage: physical keys become logical keys */
+    if constexpr (HAS_LAYERS) {
+      if (layer_count_ > 0) {
+        current_mask_ = ApplyLayers(current_mask_);
+      }
+    }
+
     uint32_t active_count = 0;
-    ButtonMaskType suppression_mask = 0;
-    ButtonMaskType consumed_mask =
+    [[maybe_unused]] ButtonMaskType suppression_mask = 0;
+    [[maybe_unused]] ButtonMaskType consumed_mask =
         0; // Record physical buttons consumed by larger combineds
 
     // Helper: update button states and count active buttons
-    auto process_button = [&](GenericButton &btn, bool input_active) {
-      instance->UpdateGenericState(btn, input_active, now);
+    auto process_button = [&](GenericButton &btn, bool input_active,
+                              uint32_t tick) {
+      [[maybe_unused]] InternalState prev_state = btn.current_state;
+      UpdateGenericState(btn, input_active, tick);
+      if constexpr (HAS_TRACE) {
+        if (btn.current_state != prev_state) {
+          Trace(BitsButtonTracePoint::STATE, btn.logic_index,
+                static_cast<uint32_t>(btn.current_state));
+        }
+      }
       if (btn.current_state != InternalState::IDLE) {
         active_count++;
       }
     };
 
     /* Process combined buttons first with greedy matching */
-    for (size_t i = instance->physical_count_; i < instance->total_count_;
-         ++i) {
-      auto &btn = instance->all_buttons_[i];
-
-      /* Check if mask matches and buttons haven't been consumed by larger
-       * combined
-       */
-      bool match =
-          (instance->current_mask_ & btn.cfg.comb.mask) == btn.cfg.comb.mask;
-      bool consumed = (consumed_mask & btn.cfg.comb.mask) != 0;
-
-      // Only non-consumed combineds can trigger
-      bool effective_active = match && !consumed;
+    if constexpr (HAS_COMBINED) {
+      for (size_t i = physical_count_; i < total_count_;
+           ++i) {
+        auto &btn = all_buttons_[i];
+
+        /* Check if mask matches and buttons haven't been consumed by larger
+         * combined
+         */
+        bool match =
+            (current_mask_ & btn.cfg.comb.care_mask) == btn.cfg.comb.mask;
+        bool consumed = (consumed_mask & btn.cfg.comb.mask) != 0;
+
+        // Only non-consumed combineds can trigger
+        bool effective_active = match && !consumed;
+        if constexpr (HAS_TRACE) {
+          if (effective_active && btn.current_state == InternalState::IDLE) {
+            Trace(BitsButtonTracePoint::COMBO_COMMIT, btn.logic_index,
+                  btn.cfg.comb.mask);
+          }
+        }
 
-      process_button(btn, effective_active);
+        process_button(btn, effective_active, now);
 
-      // If combined matches, consume physical keys to prevent smaller combineds
-      if (match) {
-        consumed_mask |= btn.cfg.comb.mask;
+        // If combined matches, consume physical keys to prevent smaller
+        // combineds
+        if (match) {
+          consumed_mask |= btn.cfg.comb.mask;
 
-        // Combined button specific suppression logic
-        if (btn.cfg.comb.suppress_single) {
-          suppression_mask |= btn.cfg.comb.mask;
+          // Combined button specific suppression logic
+          if (HAS_SUPPRESSION && btn.cfg.comb.suppress_single) {
+            suppression_mask |= btn.cfg.comb.mask;
+          }
         }
       }
     }
 
     /* Process physical buttons with suppression applied */
-    for (size_t i = 0; i < instance->physical_count_; ++i) {
-      auto &btn = instance->all_buttons_[i];
+    for (size_t i = 0; i < physical_count_; ++i) {
+      auto &btn = all_buttons_[i];
 
-      bool pressed = btn.cfg.phys.debounced_state;
-      ButtonMaskType btn_bit =
-          (static_cast<ButtonMaskType>(1UL) << btn.logic_index);
-      bool suppressed = (suppression_mask & btn_bit) != 0;
+      bool pressed = (current_mask_ & (static_cast<ButtonMaskType>(1UL)
+                                       << btn.logic_index)) != 0;
+      /* Sample buffers date confirmed edges back to their first sample */
+      uint32_t tick = now;
+      if constexpr (HAS_SAMPLE_TIMESTAMPS) {
+        if ((edge_stamp_mask_ &
+             (static_cast<ButtonMaskType>(1UL) << btn.logic_index)) != 0) {
+          tick = edge_ticks_[btn.logic_index];
+        }
+      }
 
-      if (suppressed) {
-        if (btn.current_state != InternalState::IDLE) {
-          btn.current_state = InternalState::IDLE;
-          btn.state_bits = 0;
-          btn.long_press_cnt = 0;
+      /* Switches bypass suppression and are not counted as active */
+      if constexpr (HAS_SWITCH) {
+        if (btn.cfg.phys.is_switch) {
+          UpdateSwitchState(btn, pressed, tick);
+          continue;
         }
-        btn.cfg.phys.pending_press_tick =
-            0; // Clear pending state when suppressed
-        continue;
       }
 
-      if (pressed && btn.current_state == InternalState::IDLE) {
-        if (btn.cfg.phys.is_suppressible) {
-          if (btn.cfg.phys.pending_press_tick == 0) {
-            btn.cfg.phys.pending_press_tick = now;
+      if constexpr (HAS_SUPPRESSION) {
+        ButtonMaskType btn_bit =
+            (static_cast<ButtonMaskType>(1UL) << btn.logic_index);
+        bool suppressed = (suppression_mask & btn_bit) != 0;
 
-            // Pretend we're not pressed while waiting for combined
-            pressed = false;
-          } else if (now - btn.cfg.phys.pending_press_tick <
-                     COMBINED_COMMIT_DELAY_MS) {
-            pressed = false;
+        if (suppressed) {
+          if (btn.current_state != InternalState::IDLE ||
+              btn.cfg.phys.pending_press_tick != 0) {
+            Trace(BitsButtonTracePoint::SUPPRESS, btn.logic_index, 0);
           }
+          if (btn.current_state != InternalState::IDLE) {
+            btn.current_state = InternalState::IDLE;
+            ClearHistory(btn);
+            ClearLongPressCount(btn);
+          }
+          btn.cfg.phys.pending_press_tick =
+              0; // Clear pending state when suppressed
+          continue;
+        }
+
+        if (pressed && btn.current_state == InternalState::IDLE) {
+          if (btn.cfg.phys.is_suppressible) {
+            if (btn.cfg.phys.pending_press_tick == 0) {
+              btn.cfg.phys.pending_press_tick = now;
+
+              // Pretend we're not pressed while waiting for combined
+              pressed = false;
+            } else if (now - btn.cfg.phys.pending_press_tick <
+                       COMBINED_COMMIT_DELAY_MS) {
+              pressed = false;
+            }
+          }
+        } else {
+          // Not pressed or already in other states, clear pending
+          btn.cfg.phys.pending_press_tick = 0;
         }
-      } else {
-        // Not pressed or already in other states, clear pending
-        btn.cfg.phys.pending_press_tick = 0;
       }
 
-      process_button(btn, pressed);
+      process_button(btn, pressed, tick);
+
+      if constexpr (HAS_SAMPLE_TIMESTAMPS) {
+        /* A sample-dated release keeps its edge time until RELEASED */
+        ButtonMaskType btn_bit = static_cast<ButtonMaskType>(1UL)
+                                 << btn.logic_index;
+        if (btn.current_state == InternalState::RELEASE &&
+            (edge_stamp_mask_ & btn_bit) != 0) {
+          stamped_release_mask_ |= btn_bit;
+        } else {
+          stamped_release_mask_ &= ~btn_bit;
+        }
+      }
+    }
+
+    if constexpr (HAS_WAKE_STATS) {
+      AccountWakeTick(now);
     }
 
-    /* Sleep check */
-    if (instance->current_mask_ == 0 && active_count == 0) {
-      instance->idle_hysteresis_++;
-      if (instance->idle_hysteresis_ > IDLE_SLEEP_THRESHOLD) {
-        instance->EnterSleepMode();
+    /* Sleep check, counted in elapsed periods so late ticks catch up */
+    bool idle = (current_mask_ & ~switch_mask_) == 0 && active_count == 0;
+    if constexpr (HAS_ADAPTIVE_SLEEP) {
+      TrackIdleGap(idle, now);
+    }
+    if (idle) {
+      uint32_t elapsed_ticks = 1;
+      if (idle_hysteresis_ > 0 && now - prev_tick > TIMER_INTERVAL_MS) {
+        elapsed_ticks = (now - prev_tick) / TIMER_INTERVAL_MS;
+      }
+      idle_hysteresis_ += elapsed_ticks;
+      /* Never sleep on a level still bouncing, its edges are over */
+      if (idle_hysteresis_ > sleep_threshold_ && settled) {
+        EnterSleepMode();
+        Trace(BitsButtonTracePoint::TICK_END, BITS_BTN_INVALID_INDEX,
+              current_mask_);
+        return;
       }
     } else {
-      instance->idle_hysteresis_ = 0;
+      idle_hysteresis_ = 0;
     }
+
+    UpdateDeadline(settled, now, idle);
+    Trace(BitsButtonTracePoint::TICK_END, BITS_BTN_INVALID_INDEX,
+          current_mask_);
   }
-};
\ No newline at end of file
+};
+
+using BitsButtonXR = BasicBitsButtonXR<>;
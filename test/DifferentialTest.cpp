@@ -0,0 +1,293 @@
+/*
+ * Differential replay of the optimized engines against the frozen reference
+ *
+ * Every engine gets the same input masks on the same virtual clock, one
+ * step per tick interval, and must emit the same event stream as
+ * BitsButtonReference. Inputs are a recorded session followed by seeded
+ * random traffic that mixes bounce, clicks, long holds, combos and idle
+ * gaps long enough to put the module to sleep.
+ *
+ * Usage: DifferentialTest [ticks] [seed]
+ */
+
+#include "BitsButtonXR.hpp"
+#include "reference/BitsButtonReference.hpp"
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t STEP_MS = 10;
+constexpr size_t BUTTON_COUNT = 4;
+const char *const ALIASES[BUTTON_COUNT] = {"a", "b", "c", "d"};
+
+/** Fields shared by the reference and optimized results */
+struct Record {
+  const char *key_alias;
+  uint8_t event_type;
+  uint32_t state_bits;
+  uint16_t long_press_count;
+  uint32_t system_tick;
+
+  bool operator==(const Record &other) const {
+    return std::strcmp(key_alias, other.key_alias) == 0 &&
+           event_type == other.event_type &&
+           state_bits == other.state_bits &&
+           long_press_count == other.long_press_count &&
+           system_tick == other.system_tick;
+  }
+};
+
+class Engine {
+public:
+  virtual ~Engine() = default;
+  virtual const char *Name() const = 0;
+  virtual void Step(uint32_t mask, uint32_t now) = 0;
+  virtual bool Next(Record &out) = 0;
+};
+
+/**
+ * @brief One engine instance on its own GPIOs
+ * @tparam Buttons BitsButtonReference or a BasicBitsButtonXR variant
+ * @tparam VIA_TIMER Drive GPIO edges and the timer task, or call
+ * ProcessInputs() directly
+ */
+template <typename Buttons, bool VIA_TIMER>
+class EngineUnderTest : public Engine {
+public:
+  explicit EngineUnderTest(const char *name) : name_(name) {
+    for (size_t i = 0; i < BUTTON_COUNT; ++i) {
+      hw_.Register(ALIASES[i], gpio_[i]);
+    }
+    typename Buttons::ButtonConstraints fast{20, 300, 100, 150};
+    typename Buttons::ButtonConstraints slow{50, 1000, 500, 300};
+
+    size_t tasks = LibXR::Timer::Tasks().size();
+    buttons_ = std::make_unique<Buttons>(
+        hw_, app_,
+        std::initializer_list<typename Buttons::SingleButtonConfig>{
+            {"a", false, fast},
+            {"b", false, fast},
+            {"c", false, slow},
+            {"d", false, {30, 500, 200, 200}}},
+        std::initializer_list<typename Buttons::CombinedButtonConfig>{
+            {"ab", true, {"a", "b"}, fast},
+            {"bcd", false, {"b", "c", "d"}, slow},
+            {"cd", true, {"c", "d"}, slow}});
+    ASSERT(LibXR::Timer::Tasks().size() == tasks + 1);
+    timer_ = LibXR::Timer::Tasks().back();
+  }
+
+  const char *Name() const override { return name_; }
+
+  void Step(uint32_t mask, uint32_t now) override {
+    if constexpr (VIA_TIMER) {
+      UNUSED(now);
+      for (size_t i = 0; i < BUTTON_COUNT; ++i) {
+        gpio_[i].Drive((mask & (1UL << i)) == 0);
+      }
+      if (timer_->running) {
+        timer_->fn();
+      }
+    } else {
+      buttons_->ProcessInputs(mask, now);
+    }
+  }
+
+  bool Next(Record &out) override {
+    typename Buttons::ButtonEventResult res;
+    if (!buttons_->GetEventResult(res)) {
+      return false;
+    }
+    out = {res.key_alias, static_cast<uint8_t>(res.event_type),
+           res.state_bits, res.long_press_count, res.system_tick};
+    return true;
+  }
+
+private:
+  const char *name_;
+  LibXR::HardwareContainer hw_;
+  LibXR::ApplicationManager app_;
+  LibXR::GPIO gpio_[BUTTON_COUNT];
+  std::unique_ptr<Buttons> buttons_;
+  LibXR::Timer::TimerHandle timer_ = nullptr;
+};
+
+struct LeanTraits : BitsButtonDefaultTraits {
+  static constexpr bool ENABLE_WAKE_STATS = false;
+  static constexpr size_t MAX_EVENT_SUBSCRIBERS = 0;
+  static constexpr size_t STATIC_EVENT_QUEUE_SIZE = 16;
+  static constexpr size_t MAX_LAYERS = 0;
+  static constexpr bool ENABLE_SAMPLE_TIMESTAMPS = false;
+  static constexpr bool ENABLE_QUEUE_STATS = false;
+};
+
+/** Recorded session: mask held for a number of steps */
+struct Segment {
+  uint32_t mask;
+  uint32_t steps;
+};
+
+const Segment RECORDED[] = {
+    {0x0, 20},  {0x1, 3},  {0x0, 3},  {0x1, 3},  {0x0, 40}, // Double click
+    {0x2, 60},  {0x0, 40},                                  // Long press
+    {0x3, 10},  {0x0, 40},                                  // Combo ab
+    {0x1, 2},   {0x3, 40}, {0x2, 5},  {0x0, 40},            // Staggered ab
+    {0xC, 150}, {0x0, 60},                                  // Long cd
+    {0xE, 30},  {0x6, 10}, {0x0, 60},                       // bcd, then bc
+    {0x4, 1},   {0x0, 1},  {0x4, 1},  {0x0, 1},  {0x4, 20}, // Bounce
+    {0x0, 200}, {0x8, 4},  {0x0, 4},  {0x8, 4},  {0x0, 4},  // Triple click
+    {0x8, 4},   {0x0, 300},
+};
+
+/** xorshift32, deterministic across platforms */
+class Random {
+public:
+  explicit Random(uint32_t seed) : state_(seed != 0 ? seed : 1) {}
+
+  uint32_t Next() {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return state_;
+  }
+
+  uint32_t Below(uint32_t bound) { return Next() % bound; }
+
+private:
+  uint32_t state_;
+};
+
+/**
+ * @brief Random traffic: each button flips after a drawn number of steps
+ * @note Holds are drawn from bounce, click, hold and idle ranges, so every
+ * state machine path and the sleep path are visited
+ */
+class RandomInputs {
+public:
+  explicit RandomInputs(uint32_t seed) : random_(seed) {
+    for (auto &countdown : countdown_) {
+      countdown = Draw();
+    }
+  }
+
+  uint32_t Next() {
+    for (size_t i = 0; i < BUTTON_COUNT; ++i) {
+      if (--countdown_[i] == 0) {
+        mask_ ^= 1UL << i;
+        countdown_[i] = Draw();
+      }
+    }
+    return mask_;
+  }
+
+private:
+  uint32_t Draw() {
+    uint32_t pick = random_.Below(100);
+    if (pick < 20) {
+      return 1 + random_.Below(2); /* Bounce */
+    }
+    if (pick < 70) {
+      return 3 + random_.Below(30); /* Click */
+    }
+    if (pick < 90) {
+      return 30 + random_.Below(150); /* Hold */
+    }
+    return 100 + random_.Below(400); /* Idle long enough to sleep */
+  }
+
+  Random random_;
+  uint32_t mask_ = 0;
+  uint32_t countdown_[BUTTON_COUNT];
+};
+
+void Print(const char *label, const Record &rec) {
+  std::fprintf(stderr, "  %-10s %s type=%u bits=0x%x lp=%u t=%u\n", label,
+               rec.key_alias, rec.event_type, rec.state_bits,
+               rec.long_press_count, rec.system_tick);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint64_t ticks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+  uint32_t seed = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+
+  EngineUnderTest<BitsButtonReference, true> reference("reference");
+  std::vector<std::unique_ptr<Engine>> engines;
+  engines.push_back(
+      std::make_unique<EngineUnderTest<BitsButtonXR, true>>("timer"));
+  engines.push_back(
+      std::make_unique<EngineUnderTest<BitsButtonXR, false>>("inputs"));
+  engines.push_back(
+      std::make_unique<EngineUnderTest<BasicBitsButtonXR<LeanTraits>, true>>(
+          "lean-timer"));
+  engines.push_back(
+      std::make_unique<EngineUnderTest<BasicBitsButtonXR<LeanTraits>, false>>(
+          "lean-inputs"));
+
+  RandomInputs random(seed);
+  size_t segment = 0;
+  uint32_t segment_left = RECORDED[0].steps;
+  uint64_t events = 0;
+  uint32_t now = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t tick = 0; tick < ticks; ++tick) {
+    uint32_t mask = 0;
+    if (segment < sizeof(RECORDED) / sizeof(RECORDED[0])) {
+      mask = RECORDED[segment].mask;
+      if (--segment_left == 0 &&
+          ++segment < sizeof(RECORDED) / sizeof(RECORDED[0])) {
+        segment_left = RECORDED[segment].steps;
+      }
+    } else {
+      mask = random.Next();
+    }
+
+    now += STEP_MS;
+    LibXR::host_time_us = static_cast<uint64_t>(now) * 1000;
+    reference.Step(mask, now);
+    for (auto &engine : engines) {
+      engine->Step(mask, now);
+    }
+
+    Record expected;
+    while (reference.Next(expected)) {
+      events++;
+      for (auto &engine : engines) {
+        Record actual{};
+        if (!engine->Next(actual) || !(actual == expected)) {
+          std::fprintf(stderr, "%s diverged at tick %llu (mask 0x%x)\n",
+                       engine->Name(), static_cast<unsigned long long>(tick),
+                       mask);
+          Print("reference", expected);
+          if (actual.key_alias != nullptr) {
+            Print(engine->Name(), actual);
+          }
+          return 1;
+        }
+      }
+    }
+    for (auto &engine : engines) {
+      Record extra;
+      if (engine->Next(extra)) {
+        std::fprintf(stderr, "%s emitted an extra event at tick %llu\n",
+                     engine->Name(), static_cast<unsigned long long>(tick));
+        Print(engine->Name(), extra);
+        return 1;
+      }
+    }
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::printf("%llu ticks, %llu events, %zu engines: identical\n",
+              static_cast<unsigned long long>(ticks),
+              static_cast<unsigned long long>(events), engines.size());
+  std::printf("%.2f M ticks/s per engine set\n", ticks / seconds / 1e6);
+  return 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * BitsButtonLinuxSource against fake devices
+ *
+ * A pipe carries evdev input_event records and a socketpair carries GPIO
+ * character device line events. The source waits on both with epoll and
+ * its timerfd, so the test only writes records and calls Run(). Closing
+ * the pipe's write end stands in for an unplugged device.
+ */
+
+#include "BitsButtonLinux.hpp"
+#include "TestSupport.hpp"
+#include <chrono>
+#include <cstring>
+#include <sys/socket.h>
+#include <vector>
+
+namespace {
+
+using Buttons = BitsButtonXR;
+using Source = BitsButtonLinuxSource<Buttons>;
+
+void WriteKey(int fd, uint16_t code, int32_t value) {
+  input_event events[2] = {};
+  events[0].type = EV_KEY;
+  events[0].code = code;
+  events[0].value = value;
+  events[1].type = EV_SYN;
+  events[1].code = SYN_REPORT;
+  ASSERT(write(fd, events, sizeof(events)) == sizeof(events));
+}
+
+/** One key record written in two parts, Run() in between */
+void WriteKeySplit(int fd, uint16_t code, int32_t value, Source &source) {
+  input_event event = {};
+  event.type = EV_KEY;
+  event.code = code;
+  event.value = value;
+  const auto *bytes = reinterpret_cast<const uint8_t *>(&event);
+  size_t head = sizeof(event) / 2;
+  ASSERT(write(fd, bytes, head) == static_cast<ssize_t>(head));
+  ASSERT(source.Run(20) == LibXR::ErrorCode::OK);
+  ASSERT(write(fd, bytes + head, sizeof(event) - head) ==
+         static_cast<ssize_t>(sizeof(event) - head));
+}
+
+void WriteLine(int fd, uint32_t offset, bool rising) {
+  gpio_v2_line_event event = {};
+  event.offset = offset;
+  event.id = rising ? GPIO_V2_LINE_EVENT_RISING_EDGE
+                    : GPIO_V2_LINE_EVENT_FALLING_EDGE;
+  ASSERT(write(fd, &event, sizeof(event)) == sizeof(event));
+}
+
+/**
+ * @brief Run the source until an event arrives or the time is up
+ * @return True if `type` was seen for `alias`; every event is appended
+ */
+bool RunUntil(Source &source, Buttons &buttons, const char *alias,
+              Buttons::ButtonEvent type,
+              std::vector<Buttons::ButtonEventResult> &seen,
+              int timeout_ms = 2000) {
+  auto end = std::chrono::steady_clock::now() +
+             std::chrono::milliseconds(timeout_ms);
+  while (std::chrono::steady_clock::now() < end) {
+    ASSERT(source.Run(20) == LibXR::ErrorCode::OK);
+    Buttons::ButtonEventResult res;
+    bool found = false;
+    while (buttons.GetEventResult(res)) {
+      seen.push_back(res);
+      found |=
+          std::strcmp(res.key_alias, alias) == 0 && res.event_type == type;
+    }
+    if (found) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t Count(const std::vector<Buttons::ButtonEventResult> &seen,
+             Buttons::ButtonEvent type) {
+  size_t count = 0;
+  for (const auto &res : seen) {
+    count += res.event_type == type ? 1 : 0;
+  }
+  return count;
+}
+
+} // namespace
+
+int main() {
+  using Event = Buttons::ButtonEvent;
+  constexpr auto EXTERNAL = Buttons::InputSource::EXTERNAL;
+  constexpr auto MOMENTARY = Buttons::InputType::MOMENTARY;
+
+  LibXR::HardwareContainer hw;
+  LibXR::ApplicationManager app;
+  Buttons::ButtonConstraints constraints{20, 300, 100, 100};
+  Buttons buttons(hw, app,
+                  {{"key", true, constraints, MOMENTARY, EXTERNAL},
+                   {"line", true, constraints, MOMENTARY, EXTERNAL}},
+                  {});
+  Source source(buttons);
+
+  int evdev[2];
+  int gpio[2];
+  ASSERT(pipe(evdev) == 0);
+  ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, gpio) == 0);
+
+  Expect(source.AddDevice(evdev[0], Source::DeviceType::EVDEV,
+                          {{KEY_ENTER, "key"}}) == LibXR::ErrorCode::OK,
+         "pipe accepted as evdev device");
+  Expect(source.AddDevice(gpio[0], Source::DeviceType::GPIO_CDEV,
+                          {{3, "line"}},
+                          true) == LibXR::ErrorCode::OK,
+         "socket accepted as GPIO line request");
+  Expect(source.AddDevice(evdev[0], Source::DeviceType::EVDEV,
+                          {{KEY_ESC, "missing"}}) ==
+             LibXR::ErrorCode::NOT_FOUND,
+         "unknown alias rejected");
+
+  /* evdev click: press, autorepeat records, release, click window */
+  std::vector<Buttons::ButtonEventResult> seen;
+  WriteKey(evdev[1], KEY_ENTER, 1);
+  Expect(RunUntil(source, buttons, "key", Event::PRESSED, seen),
+         "evdev press reported");
+  Expect(source.GetInputMask() == 0x1, "evdev level tracked");
+  WriteKey(evdev[1], KEY_ENTER, 2);
+  WriteKey(evdev[1], KEY_ENTER, 2);
+  WriteKey(evdev[1], KEY_ESC, 1);
+  WriteKey(evdev[1], KEY_ENTER, 0);
+  Expect(RunUntil(source, buttons, "key", Event::RELEASED, seen),
+         "evdev release reported");
+  Expect(RunUntil(source, buttons, "key", Event::CLICK_FINISH, seen),
+         "click window closed by the timerfd alone");
+  Expect(Count(seen, Event::PRESSED) == 1,
+         "autorepeat and unmapped codes ignored");
+
+  /* GPIO line, active low: falling edge presses, held into a long press */
+  seen.clear();
+  WriteLine(gpio[1], 3, false);
+  Expect(RunUntil(source, buttons, "line", Event::PRESSED, seen),
+         "GPIO falling edge reported as press");
+  Expect(source.GetInputMask() == 0x2, "GPIO level tracked");
+  Expect(RunUntil(source, buttons, "line", Event::LONG_PRESS_START, seen),
+         "long press timed by the timerfd");
+  WriteLine(gpio[1], 7, false);
+  WriteLine(gpio[1], 3, true);
+  Expect(RunUntil(source, buttons, "line", Event::RELEASED, seen),
+         "GPIO rising edge reported as release");
+  Expect(RunUntil(source, buttons, "line", Event::CLICK_FINISH, seen),
+         "GPIO click window closed");
+
+  /* A record split across reads is applied once it is complete */
+  seen.clear();
+  WriteKeySplit(evdev[1], KEY_ENTER, 1, source);
+  Expect(source.GetInputMask() == 0x0, "half a record leaves the level");
+  Expect(RunUntil(source, buttons, "key", Event::PRESSED, seen),
+         "split evdev record reported as press");
+  WriteKeySplit(evdev[1], KEY_ENTER, 0, source);
+  Expect(RunUntil(source, buttons, "key", Event::CLICK_FINISH, seen),
+         "split evdev release completes the click");
+
+  /* Settled: no deadline left, Run() just waits out its timeout */
+  seen.clear();
+  RunUntil(source, buttons, "line", Event::PRESSED, seen, 300);
+  Expect(buttons.NextDeadline() == Buttons::DEADLINE_NEVER,
+         "timerfd disarmed once idle");
+  Expect(seen.empty(), "nothing emitted while idle");
+
+  /* Hang-up with the key held: end of file drops the pipe, no busy loop */
+  WriteKey(evdev[1], KEY_ENTER, 1);
+  Expect(RunUntil(source, buttons, "key", Event::PRESSED, seen),
+         "key held before the hang-up");
+  close(evdev[1]);
+  Expect(source.Run(20) == LibXR::ErrorCode::NOT_FOUND,
+         "hang-up reported by Run()");
+  Expect(!source.IsDeviceOpen(evdev[0]), "hung-up device removed");
+  Expect(source.IsDeviceOpen(gpio[0]), "other device still watched");
+  Expect(source.GetInputMask() == 0x0, "buttons of a removed device released");
+  Expect(RunUntil(source, buttons, "key", Event::RELEASED, seen),
+         "removed device's held key reported released");
+  Expect(RunUntil(source, buttons, "key", Event::CLICK_FINISH, seen),
+         "click of the removed device completed");
+  size_t runs = 0;
+  auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+  while (std::chrono::steady_clock::now() < end) {
+    Expect(source.Run(50) == LibXR::ErrorCode::OK, "no error after removal");
+    runs++;
+  }
+  Expect(runs <= 10, "Run() waits instead of spinning after a hang-up");
+
+  close(evdev[0]);
+  close(gpio[0]);
+  close(gpio[1]);
+
+  if (test_failures != 0) {
+    return 1;
+  }
+  std::printf("Linux source: evdev pipe and GPIO socketpair OK\n");
+  return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * Multi-threaded end-to-end pipeline benchmark
+ *
+ * An ISR thread drives GPIO edges on every button, a timer thread runs the
+ * polling task on a 1 ms time base, and N consumer threads drain events.
+ * Each run reports consumed events/s, the full rate of every queue and the
+ * edge-to-consumer latency of PRESSED/RELEASED (debounce included). Runs
+ * cover the heap and the static queue, each with the shared queue read by
+ * all consumers, one fan-out queue per consumer, and one queue per consumer
+ * for its own share of the buttons.
+ *
+ * Usage: PipelineBench [seconds_per_run] [consumers] [min_hold_ms]
+ */
+
+#include "BitsButtonXR.hpp"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t BUTTON_COUNT = 16;
+const char *const ALIASES[BUTTON_COUNT] = {
+    "k0", "k1", "k2",  "k3",  "k4",  "k5",  "k6",  "k7",
+    "k8", "k9", "k10", "k11", "k12", "k13", "k14", "k15"};
+
+struct HeapTraits : BitsButtonDefaultTraits {
+  static constexpr size_t MAX_EVENT_SUBSCRIBERS = 4;
+};
+
+struct StaticTraits : HeapTraits {
+  static constexpr size_t STATIC_EVENT_QUEUE_SIZE = 16;
+};
+
+enum class Dispatch : uint8_t {
+  SHARED,      ///< Every consumer pops the shared result queue
+  FAN_OUT,     ///< One queue per consumer, each gets every event
+  PARTITIONED, ///< One queue per consumer, each gets its own buttons
+};
+
+const char *DispatchName(Dispatch dispatch) {
+  switch (dispatch) {
+  case Dispatch::SHARED:
+    return "shared";
+  case Dispatch::FAN_OUT:
+    return "fan-out";
+  case Dispatch::PARTITIONED:
+    return "partitioned";
+  }
+  return "?";
+}
+
+struct Options {
+  double seconds;
+  size_t consumers;
+  uint32_t min_hold_ms;
+};
+
+/** xorshift32, one per thread */
+class Random {
+public:
+  explicit Random(uint32_t seed) : state_(seed != 0 ? seed : 1) {}
+
+  uint32_t Between(uint32_t low, uint32_t high) {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return low + state_ % (high - low + 1);
+  }
+
+private:
+  uint32_t state_;
+};
+
+int64_t Nanoseconds(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                              start)
+      .count();
+}
+
+double Percentile(const std::vector<int64_t> &sorted, double fraction) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+  return sorted[index] / 1000.0;
+}
+
+/**
+ * @brief One run of the pipeline
+ * @tparam Buttons BasicBitsButtonXR variant, selects the queue type
+ */
+template <typename Buttons>
+void Run(const char *queue_name, Dispatch dispatch, const Options &options) {
+  using Result = typename Buttons::ButtonEventResult;
+  using Event = typename Buttons::ButtonEvent;
+
+  LibXR::HardwareContainer hw;
+  LibXR::ApplicationManager app;
+  LibXR::GPIO gpio[BUTTON_COUNT];
+  for (size_t i = 0; i < BUTTON_COUNT; ++i) {
+    hw.Register(ALIASES[i], gpio[i]);
+  }
+  typename Buttons::ButtonConstraints constraints{20, 400, 100, 100};
+  Buttons buttons(hw, app,
+                  {{"k0", false, constraints},  {"k1", false, constraints},
+                   {"k2", false, constraints},  {"k3", false, constraints},
+                   {"k4", false, constraints},  {"k5", false, constraints},
+                   {"k6", false, constraints},  {"k7", false, constraints},
+                   {"k8", false, constraints},  {"k9", false, constraints},
+                   {"k10", false, constraints}, {"k11", false, constraints},
+                   {"k12", false, constraints}, {"k13", false, constraints},
+                   {"k14", false, constraints}, {"k15", false, constraints}},
+                  {});
+  auto *timer = LibXR::Timer::Tasks().back();
+
+  std::vector<typename Buttons::SubscriberId> queues;
+  if (dispatch != Dispatch::SHARED) {
+    for (size_t c = 0; c < options.consumers; ++c) {
+      typename Buttons::ButtonIndexMask index_mask = 0;
+      for (size_t i = 0; i < BUTTON_COUNT; ++i) {
+        if (dispatch == Dispatch::FAN_OUT || i % options.consumers == c) {
+          index_mask |= static_cast<typename Buttons::ButtonIndexMask>(1)
+                        << i;
+        }
+      }
+      auto id = buttons.CreateEventQueue(index_mask, 0xFFFFFFFF, 16);
+      ASSERT(id != Buttons::INVALID_SUBSCRIBER);
+      queues.push_back(id);
+    }
+  }
+
+  auto start = Clock::now();
+  std::atomic<bool> producing = true;
+  std::atomic<bool> consuming = true;
+  std::atomic<int64_t> press_edge_ns[BUTTON_COUNT] = {};
+  std::atomic<int64_t> release_edge_ns[BUTTON_COUNT] = {};
+
+  /* ISR: every button alternates press and release with random holds */
+  std::thread isr([&]() {
+    Random rnd(1);
+    int64_t next_edge_ns[BUTTON_COUNT];
+    bool pressed[BUTTON_COUNT] = {};
+    for (auto &edge : next_edge_ns) {
+      edge = rnd.Between(0, 50) * 1000000LL;
+    }
+    while (producing.load(std::memory_order_relaxed)) {
+      size_t next = 0;
+      for (size_t i = 1; i < BUTTON_COUNT; ++i) {
+        next = next_edge_ns[i] < next_edge_ns[next] ? i : next;
+      }
+      std::this_thread::sleep_until(
+          start + std::chrono::nanoseconds(next_edge_ns[next]));
+
+      pressed[next] = !pressed[next];
+      auto &edge_ns = pressed[next] ? press_edge_ns : release_edge_ns;
+      edge_ns[next].store(Nanoseconds(start), std::memory_order_relaxed);
+      gpio[next].Drive(!pressed[next]);
+      next_edge_ns[next] +=
+          rnd.Between(options.min_hold_ms, options.min_hold_ms * 2) *
+          1000000LL;
+    }
+  });
+
+  /* Timer: 1 ms time base, runs the task every cycle while started */
+  std::thread timer_thread([&]() {
+    uint32_t elapsed = 0;
+    for (uint64_t ms = 1; producing.load(std::memory_order_relaxed); ++ms) {
+      std::this_thread::sleep_until(start + std::chrono::milliseconds(ms));
+      LibXR::host_time_us = static_cast<uint64_t>(Nanoseconds(start) / 1000);
+      if (!timer->running) {
+        elapsed = 0;
+      } else if (++elapsed >= timer->cycle) {
+        elapsed = 0;
+        timer->fn();
+      }
+    }
+  });
+
+  std::vector<std::vector<int64_t>> latencies(options.consumers);
+  std::vector<uint64_t> consumed(options.consumers);
+  std::vector<std::thread> consumers;
+  for (size_t c = 0; c < options.consumers; ++c) {
+    consumers.emplace_back([&, c]() {
+      Result res;
+      auto pop = [&]() {
+        return dispatch == Dispatch::SHARED
+                   ? buttons.GetEventResult(res)
+                   : buttons.GetEventResult(queues[c], res);
+      };
+      while (true) {
+        if (!pop()) {
+          if (!consuming.load(std::memory_order_relaxed)) {
+            break;
+          }
+          std::this_thread::yield();
+          continue;
+        }
+        consumed[c]++;
+        uint8_t index = res.logic_index;
+        if (res.event_type == Event::PRESSED ||
+            res.event_type == Event::RELEASED) {
+          auto &edge_ns = res.event_type == Event::PRESSED ? press_edge_ns
+                                                           : release_edge_ns;
+          latencies[c].push_back(
+              Nanoseconds(start) -
+              edge_ns[index].load(std::memory_order_relaxed));
+        }
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+  producing = false;
+  isr.join();
+  timer_thread.join();
+  consuming = false;
+  for (auto &consumer : consumers) {
+    consumer.join();
+  }
+  double seconds = Nanoseconds(start) / 1e9;
+
+  std::vector<int64_t> all;
+  uint64_t total = 0;
+  for (size_t c = 0; c < options.consumers; ++c) {
+    all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+    total += consumed[c];
+  }
+  std::sort(all.begin(), all.end());
+
+  /* Full rate of the queues that are read in this mode */
+  uint64_t pushed = 0;
+  uint64_t dropped = 0;
+  typename Buttons::QueueStatistics stats;
+  if (dispatch == Dispatch::SHARED) {
+    buttons.GetQueueStatistics(stats);
+    pushed += stats.pushed;
+    dropped += stats.dropped;
+  } else {
+    for (auto id : queues) {
+      buttons.GetQueueStatistics(id, stats);
+      pushed += stats.pushed;
+      dropped += stats.dropped;
+    }
+  }
+  double full_rate =
+      pushed + dropped != 0 ? 100.0 * dropped / (pushed + dropped) : 0.0;
+
+  std::printf("%-7s %-12s %9.0f %7.2f%% %9.1f %9.1f %9.1f %9.1f\n",
+              queue_name, DispatchName(dispatch), total / seconds, full_rate,
+              Percentile(all, 0.5), Percentile(all, 0.99),
+              Percentile(all, 0.999), Percentile(all, 1.0));
+  ASSERT(total > 0);
+}
+
+template <typename Buttons>
+void RunAll(const char *queue_name, const Options &options) {
+  Run<Buttons>(queue_name, Dispatch::SHARED, options);
+  Run<Buttons>(queue_name, Dispatch::FAN_OUT, options);
+  Run<Buttons>(queue_name, Dispatch::PARTITIONED, options);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  options.seconds = argc > 1 ? std::strtod(argv[1], nullptr) : 2.0;
+  options.consumers = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 3;
+  options.min_hold_ms = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 30;
+  ASSERT(options.consumers > 0 &&
+         options.consumers <= HeapTraits::MAX_EVENT_SUBSCRIBERS);
+
+  std::printf("%zu buttons, %zu consumers, holds %u-%u ms, %u hw threads\n",
+              BUTTON_COUNT, options.consumers, options.min_hold_ms,
+              options.min_hold_ms * 2, std::thread::hardware_concurrency());
+  std::printf("%-7s %-12s %9s %8s %9s %9s %9s %9s\n", "queue", "dispatch",
+              "events/s", "full", "p50 us", "p99 us", "p999 us", "max us");
+  RunAll<BasicBitsButtonXR<HeapTraits>>("heap", options);
+  RunAll<BasicBitsButtonXR<StaticTraits>>("static", options);
+  return 0;
+}
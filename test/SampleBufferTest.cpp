@@ -0,0 +1,227 @@
+/*
+ * ProcessSamples() with synthetic DMA capture buffers
+ *
+ * Buffers of raw port samples are handed to the engine the way a
+ * timer-triggered DMA would deliver them, one buffer per tick interval.
+ * Checks debounce across samples, first-edge timestamps for presses and
+ * releases, glitch rejection and independent buttons, then reports the
+ * per-sample cost on quiet and noisy ports.
+ *
+ * Usage: SampleBufferTest [buffers_for_timing]
+ */
+
+#include "BitsButtonXR.hpp"
+#include "TestSupport.hpp"
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t TICK_MS = 10;
+constexpr uint32_t PERIOD_US = 1000; ///< Ten samples per tick
+
+struct NoStampTraits : BitsButtonDefaultTraits {
+  static constexpr bool ENABLE_SAMPLE_TIMESTAMPS = false;
+};
+
+/**
+ * @brief Two EXTERNAL buttons fed with capture buffers
+ * @tparam Buttons BasicBitsButtonXR variant
+ */
+template <typename Buttons> class Capture {
+public:
+  using Result = typename Buttons::ButtonEventResult;
+  using Event = typename Buttons::ButtonEvent;
+
+  Capture()
+      : buttons_(hw_, app_,
+                 {{"a", true, CONSTRAINTS, Buttons::InputType::MOMENTARY,
+                   Buttons::InputSource::EXTERNAL},
+                  {"b", true, CONSTRAINTS, Buttons::InputType::MOMENTARY,
+                   Buttons::InputSource::EXTERNAL}},
+                 {}) {}
+
+  /**
+   * @brief Deliver one buffer ending at the next tick
+   * @return Time of the buffer's last sample
+   */
+  uint32_t Buffer(const std::vector<uint32_t> &samples,
+                  uint32_t period_us = PERIOD_US) {
+    now_ += TICK_MS;
+    buttons_.ProcessSamples(samples.data(), samples.size(), now_, period_us);
+    Result res;
+    while (buttons_.GetEventResult(res)) {
+      events_.push_back(res);
+    }
+    return now_;
+  }
+
+  /** Deliver `count` buffers holding one level */
+  void Hold(uint32_t mask, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      Buffer(std::vector<uint32_t>(TICK_MS * 1000 / PERIOD_US, mask));
+    }
+  }
+
+  /** Time of sample `index` in a buffer of `count` ending at `end` */
+  static uint32_t SampleTime(uint32_t end, size_t index, size_t count,
+                             uint32_t period_us = PERIOD_US) {
+    return end - static_cast<uint32_t>((count - 1 - index) * period_us / 1000);
+  }
+
+  /**
+   * @brief Take the first pending event of a button and type
+   * @return Its system_tick, or UINT32_MAX if there is none
+   */
+  uint32_t Take(const char *alias, Event type) {
+    for (auto it = events_.begin(); it != events_.end(); ++it) {
+      if (std::strcmp(it->key_alias, alias) == 0 && it->event_type == type) {
+        uint32_t tick = it->system_tick;
+        events_.erase(it);
+        return tick;
+      }
+    }
+    return UINT32_MAX;
+  }
+
+  size_t Pending() const { return events_.size(); }
+  void Clear() { events_.clear(); }
+
+private:
+  static constexpr typename Buttons::ButtonConstraints CONSTRAINTS = {
+      50, 1000, 500, 300};
+
+  LibXR::HardwareContainer hw_;
+  LibXR::ApplicationManager app_;
+  Buttons buttons_;
+  uint32_t now_ = 1000;
+  std::vector<Result> events_;
+};
+
+using Default = Capture<BitsButtonXR>;
+using Event = BitsButtonXR::ButtonEvent;
+
+void CleanPress() {
+  Default cap;
+  cap.Hold(0, 3);
+  uint32_t end = cap.Buffer({0, 0, 0, 0, 1, 1, 1, 1, 1, 1});
+  cap.Hold(1, 3);
+  Expect(cap.Take("a", Event::PRESSED) == Default::SampleTime(end, 4, 10),
+         "clean press stamped with its first sample");
+}
+
+void BouncyPressAndRelease() {
+  Default cap;
+  cap.Hold(0, 3);
+  uint32_t press_end = cap.Buffer({0, 0, 1, 0, 1, 0, 1, 1, 1, 1});
+  cap.Hold(1, 10);
+  uint32_t release_end = cap.Buffer({1, 1, 1, 1, 1, 0, 1, 0, 1, 0});
+  cap.Hold(0, 2);
+  Expect(cap.Take("a", Event::PRESSED) ==
+             Default::SampleTime(press_end, 2, 10),
+         "bouncy press stamped with the first departing sample");
+  Expect(cap.Take("a", Event::RELEASED) ==
+             Default::SampleTime(release_end, 5, 10),
+         "bouncy release stamped with the first departing sample");
+}
+
+void EdgeAcrossBuffers() {
+  Default cap;
+  cap.Hold(0, 3);
+  uint32_t end = cap.Buffer({0, 0, 0, 0, 0, 0, 0, 0, 0, 1});
+  Expect(cap.Pending() == 0, "single trailing sample not confirmed yet");
+  cap.Hold(1, 3);
+  Expect(cap.Take("a", Event::PRESSED) == Default::SampleTime(end, 9, 10),
+         "edge confirmed in the next buffer keeps its first sample time");
+}
+
+void Glitches() {
+  Default cap;
+  cap.Hold(0, 3);
+  cap.Buffer({0, 1, 0, 0, 1, 0, 0, 0, 1, 0});
+  cap.Buffer({1, 0, 1, 0, 0, 0, 0, 1, 0, 0});
+  cap.Hold(0, 60);
+  Expect(cap.Pending() == 0, "isolated samples never confirm a press");
+}
+
+void IndependentButtons() {
+  Default cap;
+  cap.Hold(0, 3);
+  uint32_t end = cap.Buffer({0, 2, 0, 3, 2, 3, 3, 3, 3, 3});
+  cap.Hold(3, 3);
+  Expect(cap.Take("b", Event::PRESSED) == Default::SampleTime(end, 1, 10),
+         "button b stamped with its own first sample");
+  Expect(cap.Take("a", Event::PRESSED) == Default::SampleTime(end, 3, 10),
+         "button a stamped with its own first sample");
+}
+
+void FastCapture() {
+  Default cap;
+  std::vector<uint32_t> quiet(40, 0);
+  std::vector<uint32_t> press(40, 1);
+  for (size_t i = 0; i < 23; ++i) {
+    press[i] = 0;
+  }
+  cap.Buffer(quiet, 250);
+  uint32_t end = cap.Buffer(press, 250);
+  cap.Buffer(std::vector<uint32_t>(40, 1), 250);
+  Expect(cap.Take("a", Event::PRESSED) ==
+             Default::SampleTime(end, 23, 40, 250),
+         "4 kHz capture stamped to the millisecond");
+}
+
+void WithoutTimestamps() {
+  using Buttons = BasicBitsButtonXR<NoStampTraits>;
+  Capture<Buttons> cap;
+  cap.Hold(0, 3);
+  uint32_t end = cap.Buffer({0, 0, 0, 0, 1, 1, 1, 1, 1, 1});
+  cap.Hold(1, 3);
+  Expect(cap.Take("a", Buttons::ButtonEvent::PRESSED) == end,
+         "without ENABLE_SAMPLE_TIMESTAMPS events carry the buffer time");
+}
+
+/** Per-sample cost of whole ticks, quiet port and one noisy line */
+void Timing(size_t buffers) {
+  Default cap;
+  constexpr size_t SAMPLES = 32;
+  std::vector<uint32_t> quiet(SAMPLES, 0);
+  std::vector<uint32_t> noisy(SAMPLES, 0);
+  for (size_t i = 0; i < SAMPLES; i += 3) {
+    noisy[i] = 1;
+  }
+
+  for (const auto *samples : {&quiet, &noisy}) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < buffers; ++i) {
+      cap.Buffer(*samples, TICK_MS * 1000 / SAMPLES);
+    }
+    double ns = std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    std::printf("%-6s port: %.1f ns/sample, %.0f ns/buffer of %zu\n",
+                samples == &quiet ? "quiet" : "noisy",
+                ns / (buffers * SAMPLES), ns / buffers, SAMPLES);
+    cap.Clear();
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t buffers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+
+  CleanPress();
+  BouncyPressAndRelease();
+  EdgeAcrossBuffers();
+  Glitches();
+  IndependentButtons();
+  FastCapture();
+  WithoutTimestamps();
+  if (test_failures != 0) {
+    return 1;
+  }
+  std::printf("Sample buffers: timestamps and debounce OK\n");
+  Timing(buffers);
+  return 0;
+}
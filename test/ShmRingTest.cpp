@@ -0,0 +1,124 @@
+/*
+ * Shared-memory broadcast ring: writer, seqlock reader and futex wait
+ *
+ * A memfd ring is written past its capacity and read back through a
+ * reader attached by descriptor, which must report the overrun and return
+ * the newest events in order. A reader blocked in Wait() must be woken by
+ * the next Publish(), and a named ring must disappear from /dev/shm after
+ * Unlink().
+ */
+
+#include "BitsButtonShm.hpp"
+#include "TestSupport.hpp"
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr uint32_t CAPACITY = 8;
+
+void Publish(BitsButtonShmWriter &writer, uint32_t tick) {
+  BitsButtonShmEvent event = {};
+  event.system_tick = tick;
+  event.event_type = static_cast<uint8_t>(BitsButtonEvent::PRESSED);
+  std::snprintf(event.key_alias, sizeof(event.key_alias), "k%u", tick);
+  writer.Publish(event);
+}
+
+void Overrun() {
+  BitsButtonShmWriter writer;
+  Expect(writer.Create(nullptr, CAPACITY) == LibXR::ErrorCode::OK,
+         "memfd ring created");
+  BitsButtonShmReader reader;
+  Expect(reader.Attach(writer.Fd()) == LibXR::ErrorCode::OK,
+         "reader attached by descriptor");
+
+  BitsButtonShmEvent event;
+  Expect(!reader.Read(event), "nothing to read before the first publish");
+  for (uint32_t tick = 0; tick < 3; ++tick) {
+    Publish(writer, tick);
+  }
+  for (uint32_t tick = 0; tick < 3; ++tick) {
+    Expect(reader.Read(event) && event.system_tick == tick &&
+               event.sequence == tick,
+           "events read in publish order");
+  }
+  Expect(std::strcmp(event.key_alias, "k2") == 0, "alias copied");
+  Expect(reader.Lost() == 0, "no loss within capacity");
+
+  /* Lap the reader: 20 more events into 8 slots */
+  for (uint32_t tick = 3; tick < 23; ++tick) {
+    Publish(writer, tick);
+  }
+  Expect(reader.Pending(), "overrun reader still has events pending");
+  uint32_t expected = 23 - CAPACITY;
+  while (reader.Read(event)) {
+    Expect(event.system_tick == expected && event.sequence == expected,
+           "oldest held events read in order after an overrun");
+    expected++;
+  }
+  Expect(expected == 23, "every held event read");
+  Expect(reader.Lost() == 20 - CAPACITY, "overwritten events counted lost");
+}
+
+void BlockingWait() {
+  BitsButtonShmWriter writer;
+  ASSERT(writer.Create(nullptr, CAPACITY) == LibXR::ErrorCode::OK);
+  BitsButtonShmReader reader;
+  ASSERT(reader.Attach(writer.Fd()) == LibXR::ErrorCode::OK);
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread producer([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    Publish(writer, 7);
+  });
+  bool woken = reader.Wait(5000);
+  double waited_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  producer.join();
+
+  BitsButtonShmEvent event;
+  Expect(woken, "Wait() woken by a publish");
+  Expect(waited_ms >= 40 && waited_ms < 2000,
+         "Wait() blocked until the publish, not its timeout");
+  Expect(reader.Read(event) && event.system_tick == 7,
+         "event that woke the reader is read");
+  Expect(!reader.Wait(20), "Wait() times out with nothing published");
+}
+
+void NamedUnlink() {
+  std::string name = "/bits_button_test_" + std::to_string(getpid());
+  BitsButtonShmWriter writer;
+  Expect(writer.Create(name.c_str(), CAPACITY) == LibXR::ErrorCode::OK,
+         "named ring created");
+  BitsButtonShmReader reader;
+  Expect(reader.Open(name.c_str()) == LibXR::ErrorCode::OK,
+         "named ring opened");
+  Expect(writer.Unlink() == LibXR::ErrorCode::OK, "named ring unlinked");
+  Expect(writer.Unlink() == LibXR::ErrorCode::NOT_FOUND,
+         "second unlink has nothing to remove");
+
+  BitsButtonShmReader late;
+  Expect(late.Open(name.c_str()) == LibXR::ErrorCode::NOT_FOUND,
+         "unlinked name no longer opens");
+  Publish(writer, 1);
+  BitsButtonShmEvent event;
+  Expect(reader.Read(event) && event.system_tick == 1,
+         "mapped reader keeps working after unlink");
+}
+
+} // namespace
+
+int main() {
+  Overrun();
+  BlockingWait();
+  NamedUnlink();
+  if (test_failures != 0) {
+    return 1;
+  }
+  std::printf("Shared-memory ring: overrun, ordering, wait and unlink OK\n");
+  return 0;
+}
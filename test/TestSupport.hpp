@@ -0,0 +1,25 @@
+#pragma once
+
+/*
+ * Check helpers shared by the host tests
+ *
+ * Expect() reports a failed check and carries on, so one run lists every
+ * broken expectation. A test returns non-zero when test_failures is set.
+ */
+
+#include <cstdio>
+
+/** Number of failed Expect() checks so far */
+inline int test_failures = 0;
+
+/**
+ * @brief Record a check, reporting it on stderr when it fails
+ * @param condition Checked condition
+ * @param what Description of the expectation
+ */
+inline void Expect(bool condition, const char *what) {
+  if (!condition) {
+    std::fprintf(stderr, "FAILED: %s\n", what);
+    test_failures++;
+  }
+}
@@ -0,0 +1,267 @@
+/*
+ * Chrome trace export of BitsButtonTraceBuffer
+ *
+ * A short press is replayed through ProcessInputs() on a traced module
+ * whose shared queue holds four events and is never drained. The exported
+ * JSON is parsed back: it must be well formed, every trace event must
+ * carry name, ph and ts, the tick slices must pair up, and the queue must
+ * show one push per accepted event and a drop for every rejected one.
+ */
+
+#include "BitsButtonTrace.hpp"
+#include "TestSupport.hpp"
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+/** Parsed JSON value, only what the checks need */
+struct Json {
+  enum class Type : uint8_t { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+  Type type = Type::NUL;
+  double number = 0.0;
+  std::string text;
+  std::vector<Json> items;
+  std::map<std::string, Json> members;
+
+  const Json *Find(const char *key) const {
+    auto it = members.find(key);
+    return it == members.end() ? nullptr : &it->second;
+  }
+};
+
+/** Strict recursive-descent parser, fails on any syntax error */
+class JsonParser {
+public:
+  explicit JsonParser(const std::string &text) : text_(text) {}
+
+  bool Parse(Json &out) {
+    SkipSpace();
+    if (!Value(out)) {
+      return false;
+    }
+    SkipSpace();
+    return pos_ == text_.size();
+  }
+
+private:
+  bool Value(Json &out) {
+    SkipSpace();
+    if (pos_ >= text_.size()) {
+      return false;
+    }
+    char c = text_[pos_];
+    if (c == '{') {
+      return Object(out);
+    }
+    if (c == '[') {
+      return Array(out);
+    }
+    if (c == '"') {
+      out.type = Json::Type::STRING;
+      return String(out.text);
+    }
+    if (c == '-' || std::isdigit(static_cast<unsigned char>(c))) {
+      return Number(out);
+    }
+    for (const char *word : {"true", "false", "null"}) {
+      if (text_.compare(pos_, std::strlen(word), word) == 0) {
+        pos_ += std::strlen(word);
+        out.type = word[0] == 'n' ? Json::Type::NUL : Json::Type::BOOL;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool Object(Json &out) {
+    out.type = Json::Type::OBJECT;
+    pos_++;
+    SkipSpace();
+    if (Take('}')) {
+      return true;
+    }
+    do {
+      SkipSpace();
+      std::string key;
+      if (!String(key) || (SkipSpace(), !Take(':'))) {
+        return false;
+      }
+      if (!Value(out.members[key])) {
+        return false;
+      }
+      SkipSpace();
+    } while (Take(','));
+    return Take('}');
+  }
+
+  bool Array(Json &out) {
+    out.type = Json::Type::ARRAY;
+    pos_++;
+    SkipSpace();
+    if (Take(']')) {
+      return true;
+    }
+    do {
+      out.items.emplace_back();
+      if (!Value(out.items.back())) {
+        return false;
+      }
+      SkipSpace();
+    } while (Take(','));
+    return Take(']');
+  }
+
+  bool String(std::string &out) {
+    if (!Take('"')) {
+      return false;
+    }
+    while (pos_ < text_.size() && text_[pos_] != '"') {
+      if (text_[pos_] == '\\' || static_cast<unsigned char>(text_[pos_]) < 32) {
+        return false; // The exporter never needs escapes
+      }
+      out += text_[pos_++];
+    }
+    return Take('"');
+  }
+
+  bool Number(Json &out) {
+    out.type = Json::Type::NUMBER;
+    size_t start = pos_;
+    Take('-');
+    if (!std::isdigit(static_cast<unsigned char>(Peek()))) {
+      return false;
+    }
+    while (std::isdigit(static_cast<unsigned char>(Peek())) ||
+           Peek() == '.') {
+      pos_++;
+    }
+    out.number = std::strtod(text_.c_str() + start, nullptr);
+    return true;
+  }
+
+  char Peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+
+  bool Take(char c) {
+    if (Peek() != c) {
+      return false;
+    }
+    pos_++;
+    return true;
+  }
+
+  void SkipSpace() {
+    while (std::isspace(static_cast<unsigned char>(Peek()))) {
+      pos_++;
+    }
+  }
+
+  const std::string &text_;
+  size_t pos_ = 0;
+};
+
+struct TracedTraits : BitsButtonDefaultTraits {
+  using Tracer = BitsButtonTraceBuffer<512>;
+  static constexpr size_t STATIC_EVENT_QUEUE_SIZE = 4;
+};
+
+using Buttons = BasicBitsButtonXR<TracedTraits>;
+
+} // namespace
+
+int main() {
+  LibXR::HardwareContainer hw;
+  LibXR::ApplicationManager app;
+  Buttons::ButtonConstraints constraints{20, 300, 100, 100};
+  Buttons buttons(hw, app,
+                  {{"key", true, constraints, Buttons::InputType::MOMENTARY,
+                    Buttons::InputSource::EXTERNAL}},
+                  {});
+  BitsButtonTraceBuffer<512> trace;
+  buttons.SetTracer(&trace);
+
+  /* Two clicks: PRESSED, RELEASED, PRESSED, RELEASED fill the queue, the
+   * CLICK_FINISH after them is dropped */
+  uint32_t now = 1000;
+  auto step = [&](uint32_t mask, size_t ticks) {
+    for (size_t i = 0; i < ticks; ++i) {
+      now += Buttons::TICK_INTERVAL_MS;
+      LibXR::host_time_us = static_cast<uint64_t>(now) * 1000;
+      buttons.ProcessInputs(mask, now);
+    }
+  };
+  step(0, 3);
+  step(1, 5);
+  step(0, 5);
+  step(1, 5);
+  step(0, 40);
+
+  std::string json;
+  trace.ExportChromeTrace([&](const char *chunk) { json += chunk; });
+
+  Json doc;
+  Expect(JsonParser(json).Parse(doc), "export is well-formed JSON");
+  const Json *events = doc.Find("traceEvents");
+  Expect(events != nullptr && events->type == Json::Type::ARRAY,
+         "traceEvents array present");
+  if (test_failures != 0) {
+    std::fprintf(stderr, "%s", json.c_str());
+    return 1;
+  }
+
+  std::map<std::string, size_t> names;
+  int open_ticks = 0;
+  double last_ts = 0.0;
+  bool ordered = true;
+  for (const Json &event : events->items) {
+    const Json *name = event.Find("name");
+    const Json *ph = event.Find("ph");
+    const Json *ts = event.Find("ts");
+    Expect(name != nullptr && name->type == Json::Type::STRING,
+           "every event has a name");
+    Expect(ph != nullptr && ph->type == Json::Type::STRING &&
+               ph->text.size() == 1,
+           "every event has a phase");
+    if (name == nullptr || ph == nullptr) {
+      continue;
+    }
+    names[name->text]++;
+    if (ph->text == "M") {
+      continue; // Metadata carries no timestamp
+    }
+    Expect(ts != nullptr && ts->type == Json::Type::NUMBER,
+           "every timed event has a numeric ts");
+    if (ts != nullptr) {
+      ordered &= ts->number >= last_ts;
+      last_ts = ts->number;
+    }
+    if (ph->text == "B") {
+      open_ticks++;
+    } else if (ph->text == "E") {
+      open_ticks--;
+    } else {
+      Expect(ph->text == "i", "points are instant events");
+    }
+    Expect(open_ticks == 0 || open_ticks == 1, "tick slices do not nest");
+  }
+
+  Expect(ordered, "timestamps never go backwards");
+  Expect(open_ticks == 0, "every tick slice is closed");
+  Expect(names["thread_name"] == 1, "engine lane named");
+  Expect(names["tick"] == 2 * 58, "one slice per step");
+  Expect(names["raw_edge"] == 4, "four raw edges");
+  Expect(names["debounced"] == 4, "four debounced levels");
+  Expect(names["state"] > 0, "state transitions traced");
+  Expect(names["queue_push"] == 4, "one push per event the queue accepted");
+  Expect(names["queue_drop"] == 1, "the rejected CLICK_FINISH traced");
+
+  if (test_failures != 0) {
+    return 1;
+  }
+  std::printf("Trace export: %zu events, well formed\n", events->items.size());
+  return 0;
+}
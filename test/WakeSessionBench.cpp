@@ -0,0 +1,246 @@
+/*
+ * Wake and awake-time accounting per simulated user session
+ *
+ * Each scenario is a scripted session of presses on a 1 ms virtual clock.
+ * Edges reach the module through the GPIO interrupt and the tick runs from
+ * the timer task, as on the target. At the end the session's
+ * GetWakeStatistics() is reported, so a power regression shows up as more
+ * wakes or more awake ticks for the same session. Every scenario runs with
+ * the fixed sleep hysteresis and with adaptive sleep.
+ *
+ * Usage: WakeSessionBench [session_minutes] [seed]
+ */
+
+#include "BitsButtonXR.hpp"
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr size_t BUTTON_COUNT = 3;
+const char *const ALIASES[BUTTON_COUNT] = {"ok", "up", "down"};
+
+/** One press: bounce_edges extra toggles, one per ms, open the press */
+struct Press {
+  uint32_t start_ms;
+  uint8_t button;
+  uint32_t hold_ms;
+  uint8_t bounce_edges;
+};
+
+/** xorshift32, deterministic across platforms */
+class Random {
+public:
+  explicit Random(uint32_t seed) : state_(seed != 0 ? seed : 1) {}
+
+  uint32_t Between(uint32_t low, uint32_t high) {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return low + state_ % (high - low + 1);
+  }
+
+private:
+  uint32_t state_;
+};
+
+struct Scenario {
+  const char *name;
+  void (*generate)(std::vector<Press> &, uint32_t, Random &);
+};
+
+/* Sporadic clicks, seconds apart: the common remote control case */
+void Remote(std::vector<Press> &presses, uint32_t length_ms, Random &rnd) {
+  for (uint32_t t = 2000; t < length_ms; t += rnd.Between(3000, 30000)) {
+    presses.push_back({t, static_cast<uint8_t>(rnd.Between(0, 2)),
+                       rnd.Between(60, 180), 2});
+  }
+}
+
+/* Menu navigation: bursts of quick presses, then a pause */
+void Navigation(std::vector<Press> &presses, uint32_t length_ms,
+                Random &rnd) {
+  for (uint32_t t = 1000; t < length_ms; t += rnd.Between(5000, 20000)) {
+    uint32_t burst = rnd.Between(3, 12);
+    uint32_t at = t;
+    for (uint32_t i = 0; i < burst; ++i) {
+      presses.push_back({at, static_cast<uint8_t>(rnd.Between(1, 2)),
+                         rnd.Between(50, 120), 1});
+      at += rnd.Between(150, 600);
+    }
+  }
+}
+
+/* Volume ramps: long presses with hold repeats */
+void LongHolds(std::vector<Press> &presses, uint32_t length_ms,
+               Random &rnd) {
+  for (uint32_t t = 1000; t < length_ms; t += rnd.Between(20000, 60000)) {
+    presses.push_back({t, static_cast<uint8_t>(rnd.Between(1, 2)),
+                       rnd.Between(1500, 5000), 3});
+  }
+}
+
+/* A key wedged down for most of the session, the others still used */
+void StuckKey(std::vector<Press> &presses, uint32_t length_ms, Random &rnd) {
+  presses.push_back({1000, 2, length_ms - 2000, 0});
+  for (uint32_t t = 2000; t < length_ms; t += rnd.Between(3000, 30000)) {
+    presses.push_back({t, static_cast<uint8_t>(rnd.Between(0, 1)),
+                       rnd.Between(60, 180), 2});
+  }
+}
+
+/* Worn contact: short chatter bursts that never form a press */
+void Chatter(std::vector<Press> &presses, uint32_t length_ms, Random &rnd) {
+  for (uint32_t t = 500; t < length_ms; t += rnd.Between(500, 4000)) {
+    presses.push_back({t, 0, 1, static_cast<uint8_t>(rnd.Between(1, 5))});
+  }
+}
+
+/* Worn contact that never stops chattering: the storm guard masks it */
+void WornContact(std::vector<Press> &presses, uint32_t length_ms) {
+  for (uint32_t t = 1000; t + 1000 < length_ms; t += 6) {
+    presses.push_back({t, 0, 3, 0});
+  }
+}
+
+const Scenario SCENARIOS[] = {
+    {"remote", Remote},       {"navigation", Navigation},
+    {"long-hold", LongHolds}, {"stuck-key", StuckKey},
+    {"chatter", Chatter},
+};
+
+struct WakeTraits : BitsButtonDefaultTraits {
+  static constexpr bool ENABLE_WAKE_STATS = true;
+};
+
+struct AdaptiveTraits : WakeTraits {
+  static constexpr uint16_t SLEEP_WAKE_COST_TICKS = 4;
+};
+
+struct StormTraits : WakeTraits {
+  static constexpr uint16_t STORM_EDGE_LIMIT = 5;
+};
+
+/**
+ * @brief Run one session on a fresh module and return its wake counters
+ * @tparam Buttons BasicBitsButtonXR variant
+ */
+template <typename Buttons>
+typename Buttons::WakeStatistics RunSession(const std::vector<Press> &presses,
+                                            uint32_t length_ms) {
+  LibXR::HardwareContainer hw;
+  LibXR::ApplicationManager app;
+  LibXR::GPIO gpio[BUTTON_COUNT];
+  for (size_t i = 0; i < BUTTON_COUNT; ++i) {
+    hw.Register(ALIASES[i], gpio[i]);
+  }
+  typename Buttons::ButtonConstraints constraints{50, 1000, 500, 300};
+  Buttons buttons(hw, app,
+                  {{"ok", false, constraints},
+                   {"up", false, constraints},
+                   {"down", false, constraints}},
+                  {});
+  auto *timer = LibXR::Timer::Tasks().back();
+
+  /* Level changes per ms, built from the press list */
+  std::vector<std::vector<uint8_t>> toggles(length_ms + 1);
+  for (const auto &press : presses) {
+    uint32_t t = press.start_ms;
+    for (uint8_t i = 0; i < press.bounce_edges * 2 && t < length_ms; ++i) {
+      toggles[t++].push_back(press.button);
+    }
+    toggles[t].push_back(press.button);
+    uint32_t release = t + press.hold_ms;
+    if (release <= length_ms) {
+      toggles[release].push_back(press.button);
+    }
+  }
+
+  bool level[BUTTON_COUNT] = {true, true, true};
+  uint32_t elapsed = 0;
+  for (uint32_t now = 1; now <= length_ms; ++now) {
+    LibXR::host_time_us = static_cast<uint64_t>(now) * 1000;
+    for (uint8_t button : toggles[now]) {
+      level[button] = !level[button];
+      gpio[button].Drive(level[button]);
+    }
+    if (!timer->running) {
+      elapsed = 0;
+      continue;
+    }
+    if (++elapsed >= timer->cycle) {
+      elapsed = 0;
+      timer->fn();
+    }
+    typename Buttons::ButtonEventResult res;
+    while (buttons.GetEventResult(res)) {
+    }
+  }
+
+  typename Buttons::WakeStatistics stats;
+  buttons.GetWakeStatistics(stats);
+  return stats;
+}
+
+template <typename Stats>
+void Report(const char *sleep_mode, const char *scenario, const Stats &stats,
+            uint32_t session_minutes) {
+  uint32_t top = 0;
+  for (size_t i = 1; i < BUTTON_COUNT; ++i) {
+    if (stats.keep_alive_ticks[i] > stats.keep_alive_ticks[top]) {
+      top = i;
+    }
+  }
+  double per_minute = 1.0 / session_minutes;
+  std::printf("%-8s %-11s %9.1f %11.1f %9.1f %9.1f  %s\n", sleep_mode,
+              scenario, stats.wake_count * per_minute,
+              stats.polled_ticks * per_minute,
+              stats.hysteresis_ticks * per_minute,
+              stats.awake_ms * per_minute / 1000.0,
+              stats.keep_alive_ticks[top] != 0 ? ALIASES[top] : "-");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t session_minutes =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10;
+  uint32_t seed = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+  ASSERT(session_minutes > 0);
+  uint32_t length_ms = session_minutes * 60000;
+
+  std::printf("%u min sessions, counters per minute\n", session_minutes);
+  std::printf("%-8s %-11s %9s %11s %9s %9s  %s\n", "sleep", "scenario",
+              "wakes", "awake-ticks", "idle-tick", "awake-s", "keeps-awake");
+
+  for (const auto &scenario : SCENARIOS) {
+    Random rnd(seed);
+    std::vector<Press> presses;
+    scenario.generate(presses, length_ms, rnd);
+
+    auto fixed = RunSession<BasicBitsButtonXR<WakeTraits>>(presses, length_ms);
+    Report("fixed", scenario.name, fixed, session_minutes);
+    auto adaptive =
+        RunSession<BasicBitsButtonXR<AdaptiveTraits>>(presses, length_ms);
+    Report("adaptive", scenario.name, adaptive, session_minutes);
+
+    /* Sanity: a session with presses wakes, and nothing polls while idle */
+    ASSERT(fixed.wake_count > 0 && adaptive.wake_count > 0);
+    ASSERT(fixed.awake_ms < length_ms && adaptive.awake_ms < length_ms);
+    if (std::strcmp(scenario.name, "stuck-key") == 0) {
+      ASSERT(fixed.keep_alive_ticks[2] * 2 > fixed.polled_ticks);
+    }
+  }
+
+  /* The guard masks the worn contact, which then counts as settled: the
+   * module sleeps until the line is re-enabled instead of scanning it */
+  std::vector<Press> worn;
+  WornContact(worn, length_ms);
+  auto unguarded = RunSession<BasicBitsButtonXR<WakeTraits>>(worn, length_ms);
+  Report("fixed", "worn", unguarded, session_minutes);
+  auto guarded = RunSession<BasicBitsButtonXR<StormTraits>>(worn, length_ms);
+  Report("guarded", "worn", guarded, session_minutes);
+  ASSERT(guarded.awake_ms * 4 < unguarded.awake_ms);
+  ASSERT(guarded.idle_scan_ticks * 1000 < length_ms);
+  return 0;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+/* Host stand-in for the LibXR application framework and lock-free queue */
+
+#include "libxr_def.hpp"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace LibXR {
+
+class Application {
+public:
+  virtual ~Application() = default;
+  virtual void OnMonitor() = 0;
+};
+
+class ApplicationManager {};
+
+class HardwareContainer {
+public:
+  template <typename Data> Data *Find(const char *name) {
+    auto it = entries_.find(name);
+    return it == entries_.end() ? nullptr : static_cast<Data *>(it->second);
+  }
+
+  template <typename Data> void Register(const char *name, Data &entry) {
+    entries_[name] = &entry;
+  }
+
+private:
+  std::map<std::string, void *> entries_;
+};
+
+class Event {
+public:
+  void Active(uint32_t event) { UNUSED(event); }
+};
+
+/**
+ * @brief Bounded ring with the LibXR::LockFreeQueue interface
+ * @note One producer, any number of consumers. Consumers claim an element
+ * with a compare-exchange on the head, like the LibXR queue.
+ */
+template <typename Data> class LockFreeQueue {
+public:
+  explicit LockFreeQueue(size_t length)
+      : length_(length + 1), buffer_(new Data[length + 1]) {}
+
+  ErrorCode Push(const Data &data) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t next = Increment(tail);
+    if (next == head_.load(std::memory_order_acquire)) {
+      return ErrorCode::FULL;
+    }
+    buffer_[tail] = data;
+    tail_.store(next, std::memory_order_release);
+    return ErrorCode::OK;
+  }
+
+  ErrorCode Pop(Data &data) {
+    size_t head = head_.load(std::memory_order_acquire);
+    do {
+      if (head == tail_.load(std::memory_order_acquire)) {
+        return ErrorCode::EMPTY;
+      }
+      data = buffer_[head];
+    } while (!head_.compare_exchange_weak(head, Increment(head),
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_acquire));
+    return ErrorCode::OK;
+  }
+
+  ErrorCode Peek(Data &data) {
+    size_t head = head_.load(std::memory_order_acquire);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return ErrorCode::EMPTY;
+    }
+    data = buffer_[head];
+    return ErrorCode::OK;
+  }
+
+  size_t Size() {
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return tail >= head ? tail - head : length_ - head + tail;
+  }
+
+  size_t EmptySize() { return length_ - 1 - Size(); }
+
+private:
+  size_t Increment(size_t index) const { return (index + 1) % length_; }
+
+  size_t length_;
+  std::unique_ptr<Data[]> buffer_;
+  std::atomic<size_t> head_ = 0;
+  std::atomic<size_t> tail_ = 0;
+};
+
+} // namespace LibXR
@@ -0,0 +1,114 @@
+#pragma once
+
+/*
+ * Host stand-in for LibXR::GPIO, the test sets the level and fires edges
+ *
+ * An edge that arrives while the interrupt is disabled stays pending and is
+ * delivered by the next EnableInterrupt(), like a latched EXTI flag. The
+ * engine relies on this when it re-enables interrupts on sleep and on the
+ * unmasking of a storm line.
+ */
+
+#include "libxr_def.hpp"
+#include <atomic>
+#include <functional>
+
+namespace LibXR {
+
+template <typename... Args> class Callback {
+public:
+  template <typename FunType, typename ArgType>
+  static Callback Create(FunType fun, ArgType arg) {
+    Callback cb;
+    cb.fun_ = [fun, arg](bool in_isr, Args... args) {
+      fun(in_isr, arg, args...);
+    };
+    return cb;
+  }
+
+  void Run(bool in_isr, Args... args) const {
+    if (fun_) {
+      fun_(in_isr, args...);
+    }
+  }
+
+private:
+  std::function<void(bool, Args...)> fun_;
+};
+
+class GPIO {
+public:
+  enum class Direction : uint8_t {
+    INPUT,
+    OUTPUT_PUSH_PULL,
+    OUTPUT_OPEN_DRAIN,
+    FALL_INTERRUPT,
+    RISING_INTERRUPT,
+    FALL_RISING_INTERRUPT,
+  };
+
+  enum class Pull : uint8_t { NONE, UP, DOWN };
+
+  struct Configuration {
+    Direction direction;
+    Pull pull;
+  };
+
+  using Callback = LibXR::Callback<>;
+
+  bool Read() { return level_.load(std::memory_order_relaxed); }
+
+  ErrorCode Write(bool value) {
+    level_.store(value, std::memory_order_relaxed);
+    return ErrorCode::OK;
+  }
+
+  ErrorCode EnableInterrupt() {
+    irq_enabled_ = true;
+    if (irq_pending_.exchange(false)) {
+      callback_.Run(true);
+    }
+    return ErrorCode::OK;
+  }
+
+  ErrorCode DisableInterrupt() {
+    irq_enabled_ = false;
+    return ErrorCode::OK;
+  }
+
+  ErrorCode SetConfig(Configuration config) {
+    config_ = config;
+    return ErrorCode::OK;
+  }
+
+  ErrorCode RegisterCallback(Callback cb) {
+    callback_ = cb;
+    return ErrorCode::OK;
+  }
+
+  /**
+   * @brief Drive the pin, running the callback like an edge interrupt
+   * @param level New pin level
+   */
+  void Drive(bool level) {
+    if (level_.exchange(level, std::memory_order_relaxed) == level) {
+      return;
+    }
+    if (irq_enabled_) {
+      callback_.Run(true);
+    } else {
+      irq_pending_ = true;
+    }
+  }
+
+  bool InterruptEnabled() const { return irq_enabled_; }
+
+private:
+  std::atomic<bool> level_ = true;
+  std::atomic<bool> irq_enabled_ = false;
+  std::atomic<bool> irq_pending_ = false;
+  Configuration config_{};
+  Callback callback_;
+};
+
+} // namespace LibXR
@@ -0,0 +1,44 @@
+#pragma once
+
+/* Host stand-in for the LibXR definitions used by BitsButtonXR */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#define ASSERT(x)                                                              \
+  do {                                                                         \
+    if (!(x)) {                                                                \
+      std::fprintf(stderr, "%s:%d: ASSERT(%s) failed\n", __FILE__, __LINE__,   \
+                   #x);                                                        \
+      std::abort();                                                            \
+    }                                                                          \
+  } while (0)
+
+#define UNUSED(x) (void)(x)
+
+namespace LibXR {
+
+enum class ErrorCode : int8_t {
+  OK = 0,
+  FAILED = -1,
+  INIT_ERR = -2,
+  ARG_ERR = -3,
+  STATE_ERR = -4,
+  SIZE_ERR = -5,
+  CHECK_ERR = -6,
+  NOT_SUPPORT = -7,
+  NOT_FOUND = -8,
+  NO_RESPONSE = -9,
+  NO_MEM = -10,
+  NO_BUFF = -11,
+  TIMEOUT = -12,
+  EMPTY = -13,
+  FULL = -14,
+  BUSY = -15,
+  PTR_NULL = -16,
+  OUT_OF_RANGE = -17,
+};
+
+} // namespace LibXR
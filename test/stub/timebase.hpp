@@ -0,0 +1,45 @@
+#pragma once
+
+/* Host stand-in for LibXR::Timebase, driven by the virtual clock */
+
+#include "libxr_def.hpp"
+#include <atomic>
+
+namespace LibXR {
+
+/**
+ * @brief Virtual time shared by every stub, in microseconds
+ * @note Tests advance it by hand, benchmarks copy a steady clock into it
+ */
+inline std::atomic<uint64_t> host_time_us = 0;
+
+class MicrosecondTimestamp {
+public:
+  MicrosecondTimestamp(uint64_t us = 0) : us_(us) {}
+  operator uint64_t() const { return us_; }
+
+private:
+  uint64_t us_;
+};
+
+class MillisecondTimestamp {
+public:
+  MillisecondTimestamp(uint32_t ms = 0) : ms_(ms) {}
+  operator uint32_t() const { return ms_; }
+
+private:
+  uint32_t ms_;
+};
+
+class Timebase {
+public:
+  static MicrosecondTimestamp GetMicroseconds() {
+    return host_time_us.load(std::memory_order_relaxed);
+  }
+  static MillisecondTimestamp GetMilliseconds() {
+    return static_cast<uint32_t>(host_time_us.load(std::memory_order_relaxed) /
+                                 1000);
+  }
+};
+
+} // namespace LibXR
@@ -0,0 +1,53 @@
+#pragma once
+
+/* Host stand-in for LibXR::Timer, tasks run when the test says so */
+
+#include "libxr_def.hpp"
+#include "timebase.hpp"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace LibXR {
+
+class Thread {
+public:
+  static uint32_t GetTime() { return Timebase::GetMilliseconds(); }
+};
+
+class Timer {
+public:
+  struct ControlBlock {
+    std::function<void()> fn;         ///< Bound task
+    std::atomic<uint32_t> cycle = 0;  ///< Period in ms
+    std::atomic<bool> running = false; ///< Started and not stopped
+  };
+
+  using TimerHandle = ControlBlock *;
+
+  template <typename ArgType>
+  static TimerHandle CreateTask(void (*fn)(ArgType), ArgType arg,
+                                uint32_t cycle) {
+    auto *handle = new ControlBlock;
+    handle->fn = [fn, arg]() { fn(arg); };
+    handle->cycle = cycle;
+    return handle;
+  }
+
+  static void Add(TimerHandle handle) { Tasks().push_back(handle); }
+  static void Start(TimerHandle handle) { handle->running = true; }
+  static void Stop(TimerHandle handle) { handle->running = false; }
+  static void SetCycle(TimerHandle handle, uint32_t cycle) {
+    handle->cycle = cycle;
+  }
+
+  /**
+   * @brief Every task added so far, in creation order
+   */
+  static std::vector<TimerHandle> &Tasks() {
+    static std::vector<TimerHandle> tasks;
+    return tasks;
+  }
+};
+
+} // namespace LibXR